@@ -0,0 +1,79 @@
+#include "bench.h"
+#include "fast-json/batchload.h"
+#include <cstdlib>
+#include <fstream>
+
+int main() {
+    // Many small files, as in a directory of documents to index
+    auto dir = std::filesystem::temp_directory_path() / "fast_json_batch_bench";
+    std::filesystem::create_directories(dir);
+    auto paths = std::vector<std::filesystem::path>{};
+    size_t total_size = 0;
+    for (int i = 0; i < 20000; ++i) {
+        auto content = bench::generate_document(i % 8 + 1);
+        paths.push_back(dir / (std::to_string(i) + ".json"));
+        std::ofstream{paths.back()} << content;
+        total_size += content.size();
+    }
+    std::cout << "files: " << paths.size() << ", total size "
+              << total_size / 1000000 << " MB\n";
+
+    auto load_sequential = [&] {
+        size_t count = 0;
+        for (auto &path : paths) {
+            auto text = json::read_file_content(path);
+            count += !json::parse_json(text)->empty();
+        }
+        if (count != paths.size()) {
+            std::abort();
+        }
+    };
+
+    auto load_batch = [&](bool use_io_uring) {
+        auto options = json::BatchLoadOptions{};
+        options.use_io_uring = use_io_uring;
+        size_t count = 0;
+        json::load_files(
+            paths,
+            [&](json::LoadedFile &file) {
+                count += file.document && !file.document->root().empty();
+            },
+            options);
+        if (count != paths.size()) {
+            std::abort();
+        }
+    };
+
+    bench::run("read_file_content, parse_json", total_size, load_sequential);
+    bench::run("BatchLoader, blocking reads", total_size, [&] {
+        load_batch(false);
+    });
+    bench::run("BatchLoader, io_uring", total_size, [&] { load_batch(true); });
+
+    // The files are read from the device when the page cache can be dropped,
+    // which requires root
+    auto drop_caches = [] {
+        return std::system("sync; echo 3 > /proc/sys/vm/drop_caches "
+                           "2> /dev/null") == 0;
+    };
+    if (drop_caches()) {
+        // Not bench::run(), since the warm up would fill the cache
+        auto run_cold = [&](std::string_view name, auto f) {
+            drop_caches();
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+            std::cout << std::left << std::setw(32) << name << std::right
+                      << std::setw(10) << std::fixed << std::setprecision(1)
+                      << total_size / seconds / 1e6 << " MB/s\n";
+        };
+        std::cout << "with cold page cache:\n";
+        run_cold("read_file_content, parse_json", load_sequential);
+        run_cold("BatchLoader, blocking reads", [&] { load_batch(false); });
+        run_cold("BatchLoader, io_uring", [&] { load_batch(true); });
+    }
+
+    std::filesystem::remove_all(dir);
+}
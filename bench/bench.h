@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+// Minimal helpers for timing. Build with optimizations (for example
+// -DCMAKE_BUILD_TYPE=Release) to get relevant numbers
+
+namespace bench {
+
+/// Generate a document with a mix of objects, arrays, strings and numbers
+inline std::string generate_document(size_t num_records) {
+    auto gen = std::mt19937{1};
+    auto dist = std::uniform_real_distribution<double>{-1000, 1000};
+    auto str = std::string{"[\n"};
+    for (size_t i = 0; i < num_records; ++i) {
+        if (i) {
+            str += ",\n";
+        }
+        str += R"(  {"id": )" + std::to_string(i) + R"(, "name": "record )" +
+               std::to_string(i) + R"( with \"escaped\" text", "values": [)";
+        for (int j = 0; j < 5; ++j) {
+            str += (j ? ", " : "") + std::to_string(dist(gen));
+        }
+        str += R"(], "nested": {"flag": true, "empty": null, "list": []}})";
+    }
+    str += "\n]\n";
+    return str;
+}
+
+/// Run `f` repeatedly and print the throughput in MB/s
+template <typename F>
+void run(std::string_view name, size_t bytes, F f, int iterations = 10) {
+    using clock = std::chrono::steady_clock;
+    f(); // Warm up
+    auto start = clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+    auto mb_per_second =
+        static_cast<double>(bytes) * iterations / seconds / 1e6;
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(1)
+              << mb_per_second << " MB/s\n";
+}
+
+} // namespace bench
@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "fast-json/columnar.h"
+#include <cstdlib>
+
+int main() {
+    auto document = bench::generate_document(100000);
+
+    // One record per line, as NDJSON
+    auto root = json::parse_json(document);
+    auto input = std::string{};
+    for (auto &record : root->elements()) {
+        input += record.value().value;
+        input += "\n";
+    }
+    std::cout << "input size: " << input.size() / 1000000 << " MB\n";
+
+    auto specs = std::vector<json::ColumnSpec>{
+        {"/id", json::ColumnType::Int64},
+        {"/name", json::ColumnType::String},
+        {"/nested/flag", json::ColumnType::Bool},
+    };
+
+    bench::run("parse_json per record", input.size(), [&] {
+        auto ids = std::vector<int64_t>{};
+        auto names = std::vector<std::string>{};
+        auto flags = std::vector<bool>{};
+        for (size_t pos = 0; pos < input.size();) {
+            auto end = input.find('\n', pos);
+            auto root = json::parse_json(
+                std::string_view{input}.substr(pos, end - pos));
+            ids.push_back((*root)["id"].number<int64_t>());
+            names.push_back((*root)["name"].str());
+            flags.push_back((*root)["nested"]["flag"].boolean());
+            pos = end + 1;
+        }
+        if (ids.size() != 100000) {
+            std::abort();
+        }
+    });
+
+    bench::run("extract_columns", input.size(), [&] {
+        auto columns = json::extract_columns(input, specs);
+        if (columns[0].size() != 100000) {
+            std::abort();
+        }
+    });
+
+    bench::run("extract_columns (4 threads)", input.size(), [&] {
+        auto columns = json::extract_columns(input, specs, 4);
+        if (columns[0].size() != 100000) {
+            std::abort();
+        }
+    });
+}
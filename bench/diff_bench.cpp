@@ -0,0 +1,37 @@
+#include "bench.h"
+#include "fast-json/diff.h"
+#include <cstdlib>
+
+int main() {
+    auto input = bench::generate_document(100000);
+    std::cout << "document size: " << input.size() / 1000000 << " MB\n";
+
+    // The same document with one changed record
+    auto changed = input;
+    auto pos = changed.find(R"("id": 5000,)");
+    changed.replace(pos, 11, R"("id": 5001,)");
+
+    auto a = json::parse_json(input);
+    auto b = json::parse_json(changed);
+
+    bench::run("structural_hash", input.size(), [&] {
+        if (!json::structural_hash(*a)) {
+            std::abort();
+        }
+    });
+
+    bench::run("diff (one change)", input.size() * 2, [&] {
+        if (json::diff(*a, *b).size() != 1) {
+            std::abort();
+        }
+    });
+
+    // With hashes remembered from earlier diffs
+    auto cache_a = json::HashCache{};
+    auto cache_b = json::HashCache{};
+    bench::run("diff (cached hashes)", input.size() * 2, [&] {
+        if (json::diff(*a, *b, &cache_a, &cache_b).size() != 1) {
+            std::abort();
+        }
+    });
+}
@@ -0,0 +1,47 @@
+#include "bench.h"
+#include "fast-json/incremental.h"
+#include <cstdlib>
+
+int main() {
+    auto input = bench::generate_document(50000);
+    std::cout << "input size: " << input.size() / 1000000 << " MB\n";
+
+    // Edit the id of a record in the middle, as an editor would. The
+    // throughput is for the whole document, as if it was parsed again
+    auto offset = input.find(R"("id": 25000)") + 6;
+    auto text = input;
+    auto parser = json::Parser{};
+    int i = 0;
+    bench::run("full parse after edit", input.size(), [&] {
+        text.replace(offset, 5, ++i % 2 ? "12345" : "54321");
+        if (parser.parse(text)->size() != 50000) {
+            std::abort();
+        }
+    });
+
+    auto doc = json::IncrementalDocument{input};
+    bench::run(
+        "apply_edit, same size",
+        input.size(),
+        [&] {
+            auto id = std::string_view{++i % 2 ? "12345" : "54321"};
+            auto &node = doc.apply_edit(offset, id.size(), id);
+            if (node.size() != 4) {
+                std::abort();
+            }
+        },
+        1000);
+
+    i = 0;
+    bench::run(
+        "apply_edit, moved text",
+        input.size(),
+        [&] {
+            auto id = std::string_view{++i % 2 ? "123456" : "12345"};
+            auto &node = doc.apply_edit(offset, 11 - id.size(), id);
+            if (node.size() != 4) {
+                std::abort();
+            }
+        },
+        100);
+}
@@ -0,0 +1,68 @@
+#include "bench.h"
+#include "fast-json/json.h"
+#include <cstdlib>
+
+int main() {
+    auto input = bench::generate_document(100000);
+    std::cout << "document size: " << input.size() / 1000000 << " MB\n";
+
+    bench::run("parse_json (lenient)", input.size(), [&] {
+        auto root = json::parse_json(input);
+    });
+
+    bench::run("parse_json (strict)", input.size(), [&] {
+        auto root = json::parse_json(input, json::ParseOptions{.strict = true});
+    });
+
+    bench::run("parse_json (validate_utf8)", input.size(), [&] {
+        auto root =
+            json::parse_json(input, json::ParseOptions{.validate_utf8 = true});
+    });
+
+    bench::run("validate_json", input.size(), [&] {
+        json::validate_json(input);
+    });
+
+    bench::run("is_valid_utf8", input.size(), [&] {
+        if (!json::is_valid_utf8(input)) {
+            std::abort();
+        }
+    });
+
+    auto text = std::string{};
+    while (text.size() < input.size()) {
+        text += "Ünïcödé text with ascii — and 𝄞 symbols. ";
+    }
+    bench::run("is_valid_utf8 (non ascii)", text.size(), [&] {
+        if (!json::is_valid_utf8(text)) {
+            std::abort();
+        }
+    });
+
+    // Only the tree building, from already tokenized input
+    auto tokens = std::pmr::vector<json::Token>{};
+    auto stack = json::json_internal::ParseStack{};
+    auto num_nodes = json::json_internal::tokenize(input, tokens, {}, stack);
+    auto nodes = std::pmr::vector<json::JsonNode>{};
+    bench::run("parse_tokens", input.size(), [&] {
+        json::json_internal::parse_tokens(
+            input, tokens, num_nodes, nodes, stack);
+    });
+
+    auto root = json::parse_json(input);
+    bench::run("index all elements", input.size(), [&] {
+        double sum = 0;
+        auto &array = *root;
+        for (size_t i = 0; i < array.size(); ++i) {
+            sum += array[i]["values"][4].number<double>();
+        }
+        if (sum == 0) {
+            std::abort();
+        }
+    });
+
+    auto parser = json::Parser{};
+    bench::run("Parser::parse (reused)", input.size(), [&] {
+        parser.parse(input);
+    });
+}
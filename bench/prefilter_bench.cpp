@@ -0,0 +1,43 @@
+#include "bench.h"
+#include "fast-json/prefilter.h"
+#include <cstdlib>
+
+int main() {
+    // A log where one record in a thousand is a error
+    auto input = std::string{};
+    for (int i = 0; i < 200000; ++i) {
+        input += R"({"time": )" + std::to_string(1700000000 + i) +
+                 R"(, "level": ")" + (i % 1000 ? "info" : "error") +
+                 R"(", "msg": "request \"/api/items\" took )" +
+                 std::to_string(i % 97) + R"( ms", "user": {"id": )" +
+                 std::to_string(i % 5000) + "}}\n";
+    }
+    std::cout << "input size: " << input.size() / 1000000 << " MB\n";
+
+    auto filter = json::RecordFilter{};
+    filter.equals("/level", R"("error")");
+
+    bench::run("parse all records", input.size(), [&] {
+        size_t count = 0;
+        auto parser = json::Parser{};
+        for (size_t pos = 0; pos < input.size();) {
+            auto end = input.find('\n', pos);
+            auto &record =
+                parser.parse(std::string_view{input}.substr(pos, end - pos));
+            count += filter.matches(*record);
+            pos = end + 1;
+        }
+        if (count != 200) {
+            std::abort();
+        }
+    });
+
+    bench::run("for_each_matching_record", input.size(), [&] {
+        size_t count = 0;
+        json::for_each_matching_record(
+            input, filter, [&](auto, auto &) { ++count; });
+        if (count != 200) {
+            std::abort();
+        }
+    });
+}
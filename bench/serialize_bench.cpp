@@ -0,0 +1,47 @@
+#include "bench.h"
+#include "fast-json/json.h"
+#include "fast-json/parallelout.h"
+#include "fast-json/serialize.h"
+#include <sstream>
+#include <vector>
+
+namespace {
+
+struct Record {
+    int id = 0;
+    std::string name;
+    std::vector<double> values;
+
+    FAST_JSON_SERIALIZE_INTRUSIVE(id, name, values);
+};
+
+} // namespace
+
+int main() {
+    auto records = std::vector<Record>{};
+    for (int i = 0; i < 200000; ++i) {
+        records.push_back({i,
+                           "record " + std::to_string(i),
+                           {i * 0.25, i * 0.5, 1.0, 2.0, 3.0}});
+    }
+
+    auto size = std::ostringstream{};
+    {
+        auto out = json::JsonOut{size};
+        out = records;
+    }
+    auto bytes = size.str().size();
+    std::cout << "output size: " << bytes / 1000000 << " MB\n";
+
+    bench::run("JsonOut (sequential)", bytes, [&] {
+        auto ss = std::ostringstream{};
+        auto out = json::JsonOut{ss};
+        out = records;
+    });
+
+    bench::run("write_array_parallel (4 threads)", bytes, [&] {
+        auto ss = std::ostringstream{};
+        auto out = json::JsonOut{ss};
+        json::write_array_parallel(out, records, 4);
+    });
+}
@@ -0,0 +1,36 @@
+#include "bench.h"
+#include "fast-json/transform.h"
+#include "fast-json/writer.h"
+#include <cstdlib>
+
+int main() {
+    constexpr size_t num_records = 100000;
+    auto input = bench::generate_document(num_records);
+    std::cout << "document size: " << input.size() / 1000000 << " MB\n";
+
+    // Drop one member and rename another in each record
+    auto transform = json::JsonTransform{};
+    transform.drop("/*/nested").rename("/*/name", "title");
+    auto expected = transform.apply(input);
+
+    bench::run("parse and MutableDocument", input.size(), [&] {
+        auto doc = json::MutableDocument{input};
+        for (size_t i = 0; i < num_records; ++i) {
+            auto pointer = "/" + std::to_string(i);
+            doc.remove(pointer + "/nested");
+            doc.rename(pointer + "/name", "title");
+        }
+        if (json::to_json_string(doc).empty()) {
+            std::abort();
+        }
+    });
+
+    auto out = std::string{};
+    bench::run("JsonTransform", input.size(), [&] {
+        out.clear();
+        transform.apply(input, out);
+        if (out.size() != expected.size()) {
+            std::abort();
+        }
+    });
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "json.h"
+#include "splitter.h"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+namespace json {
+
+/// A source of bytes for the async parser. `read()` returns something that
+/// can be awaited and gives the number of bytes written to the buffer, where 0
+/// means that the end of the input is reached. For example
+///
+///   struct Connection {
+///       ReadAwaiter read(std::span<char> buffer);
+///   };
+template <typename T>
+concept AsyncByteSource = requires(T &source, std::span<char> buffer) {
+    source.read(buffer);
+};
+
+namespace json_internal {
+
+/// Resume the awaiting coroutine when a coroutine finishes or yields
+struct ContinuationAwaiter {
+    std::coroutine_handle<> continuation;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<>) noexcept {
+        if (continuation) {
+            return continuation;
+        }
+        return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+} // namespace json_internal
+
+/// A lazily started coroutine that returns a value. Start it by co_await:ing
+/// it from another coroutine, or with start() from normal code
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+    struct promise_type {
+        Task get_return_object() {
+            return Task{handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        json_internal::ContinuationAwaiter final_suspend() noexcept {
+            return {continuation};
+        }
+
+        template <typename U>
+        void return_value(U &&value) {
+            result.emplace(std::forward<U>(value));
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+        std::optional<T> result;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation;
+    };
+
+    using handle = std::coroutine_handle<promise_type>;
+
+    Task(Task &&other) noexcept
+        : _handle{std::exchange(other._handle, {})} {}
+
+    Task &operator=(Task &&other) noexcept {
+        std::swap(_handle, other._handle);
+        return *this;
+    }
+
+    ~Task() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+        _handle.promise().continuation = awaiting;
+        return _handle;
+    }
+
+    T await_resume() {
+        return get();
+    }
+
+    /// Run the task until its first suspension point, when it is not awaited
+    /// by another coroutine
+    void start() {
+        _handle.resume();
+    }
+
+    bool is_done() const {
+        return _handle.done();
+    }
+
+    /// The result of a finished task. Rethrows if the task failed
+    T get() {
+        auto &promise = _handle.promise();
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+        return std::move(*promise.result);
+    }
+
+private:
+    explicit Task(handle h)
+        : _handle{h} {}
+
+    handle _handle;
+};
+
+template <>
+struct Task<void>::promise_type {
+    Task get_return_object() {
+        return Task{handle::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+
+    json_internal::ContinuationAwaiter final_suspend() noexcept {
+        return {continuation};
+    }
+
+    void return_void() {}
+
+    void unhandled_exception() {
+        exception = std::current_exception();
+    }
+
+    std::exception_ptr exception;
+    std::coroutine_handle<> continuation;
+};
+
+template <>
+inline void Task<void>::get() {
+    if (auto &exception = _handle.promise().exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+/// A coroutine that produces values with co_yield and that can co_await
+/// while producing them. The consumer uses `co_await generator.next()` that
+/// gives a pointer to the value, or null at the end. The value is valid until
+/// the next call to next()
+template <typename T>
+class [[nodiscard]] AsyncGenerator {
+public:
+    struct promise_type {
+        AsyncGenerator get_return_object() {
+            return AsyncGenerator{handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        json_internal::ContinuationAwaiter final_suspend() noexcept {
+            value = nullptr;
+            return {consumer};
+        }
+
+        json_internal::ContinuationAwaiter yield_value(T &v) noexcept {
+            value = &v;
+            return {consumer};
+        }
+
+        json_internal::ContinuationAwaiter yield_value(T &&v) noexcept {
+            value = &v;
+            return {consumer};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+        T *value = nullptr;
+        std::exception_ptr exception;
+        std::coroutine_handle<> consumer;
+    };
+
+    using handle = std::coroutine_handle<promise_type>;
+
+    struct NextAwaiter {
+        handle generator;
+
+        bool await_ready() const noexcept {
+            return generator.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) {
+            generator.promise().consumer = consumer;
+            return generator;
+        }
+
+        T *await_resume() {
+            auto &promise = generator.promise();
+            if (promise.exception) {
+                std::rethrow_exception(std::exchange(promise.exception, {}));
+            }
+            return generator.done() ? nullptr : promise.value;
+        }
+    };
+
+    AsyncGenerator(AsyncGenerator &&other) noexcept
+        : _handle{std::exchange(other._handle, {})} {}
+
+    AsyncGenerator &operator=(AsyncGenerator &&other) noexcept {
+        std::swap(_handle, other._handle);
+        return *this;
+    }
+
+    ~AsyncGenerator() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    NextAwaiter next() {
+        return {_handle};
+    }
+
+private:
+    explicit AsyncGenerator(handle h)
+        : _handle{h} {}
+
+    handle _handle;
+};
+
+/// Read everything from `source` and append it to `buffer`
+template <AsyncByteSource Source>
+Task<> read_all_async(Source &source,
+                      std::string &buffer,
+                      size_t chunk_size = 64 * 1024) {
+    while (true) {
+        auto old_size = buffer.size();
+        buffer.resize(old_size + chunk_size);
+        size_t size = co_await source.read(
+            std::span<char>{buffer.data() + old_size, chunk_size});
+        buffer.resize(old_size + size);
+        if (!size) {
+            co_return;
+        }
+    }
+}
+
+/// Read a whole document from `source` into `buffer` and parse it. The nodes
+/// refers to `buffer` that needs to be kept alive by the caller
+template <AsyncByteSource Source>
+Task<JsonRoot> parse_json_async(Source &source,
+                                std::string &buffer,
+                                ParseOptions options = {}) {
+    co_await read_all_async(source, buffer);
+    co_return parse_json(buffer, options);
+}
+
+/// Parse each NDJSON record (SplitMode::Values) or each element of a top
+/// level array (SplitMode::ArrayElements) as soon as it is complete. Only the
+/// incomplete record is kept in memory between reads. The yielded document
+/// is valid until the next call to next()
+template <AsyncByteSource Source>
+AsyncGenerator<JsonRoot> parse_records_async(
+    Source &source,
+    SplitMode mode = SplitMode::Values,
+    ParseOptions options = {},
+    size_t chunk_size = 64 * 1024) {
+    auto buffer = std::string{};
+    auto splitter = RecordSplitter{mode};
+
+    while (true) {
+        for (auto record = splitter.next(buffer); !record.empty();
+             record = splitter.next(buffer)) {
+            co_yield parse_json(record, options);
+        }
+        if (splitter.is_done()) {
+            break;
+        }
+
+        // Records that has been yielded are no longer used
+        auto consumed = splitter.consumed();
+        buffer.erase(0, consumed);
+        splitter.discard(consumed);
+
+        auto old_size = buffer.size();
+        buffer.resize(old_size + chunk_size);
+        size_t size = co_await source.read(
+            std::span<char>{buffer.data() + old_size, chunk_size});
+        buffer.resize(old_size + size);
+        if (!size) {
+            break;
+        }
+    }
+
+    for (auto record = splitter.next(buffer); !record.empty();
+         record = splitter.next(buffer)) {
+        co_yield parse_json(record, options);
+    }
+    if (auto record = splitter.finish(buffer); !record.empty()) {
+        co_yield parse_json(record, options);
+    }
+}
+
+} // namespace json
@@ -0,0 +1,572 @@
+#pragma once
+
+#include "document.h"
+#include "queue.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// io_uring is used directly through the system calls, so no library is needed
+// but the kernel headers
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define FAST_JSON_HAS_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
+#endif
+
+namespace json {
+
+struct BatchLoadOptions {
+    /// The number of threads that parses the files
+    size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    /// The number of files that is read at the same time with io_uring
+    size_t queue_depth = 64;
+
+    /// Read with blocking reads on the parsing threads instead of io_uring
+    bool use_io_uring = true;
+
+    ParseOptions parse_options = {};
+};
+
+/// The result for one file from BatchLoader. If the file could not be read
+/// or parsed, `document` is null and `error` is set
+struct LoadedFile {
+    /// The position of the file in the list given to the loader
+    size_t index = 0;
+    std::filesystem::path path;
+    std::shared_ptr<const Document> document;
+    std::exception_ptr error;
+};
+
+namespace json_internal {
+
+/// The text of a file that is read but not yet parsed
+struct FileContent {
+    size_t index = 0;
+    std::string text;
+    std::exception_ptr error;
+};
+
+#ifdef FAST_JSON_HAS_IO_URING
+
+/// A minimal io_uring instance for reads. Requests are prepared in the
+/// submission queue and submitted in one system call, and the results are
+/// taken from the completion queue
+class IoUring {
+public:
+    explicit IoUring(unsigned entries) {
+        auto params = io_uring_params{};
+        _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (_fd < 0) {
+            throw std::system_error{
+                errno, std::system_category(), "io_uring_setup"};
+        }
+
+        try {
+            _sq_size =
+                params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            _cq_size =
+                params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool is_single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (is_single_mmap) {
+                _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+            }
+            _sq_ring = map(_sq_size, IORING_OFF_SQ_RING);
+            _cq_ring =
+                is_single_mmap ? _sq_ring : map(_cq_size, IORING_OFF_CQ_RING);
+            _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            _sqes =
+                static_cast<io_uring_sqe *>(map(_sqes_size, IORING_OFF_SQES));
+        }
+        catch (...) {
+            release();
+            throw;
+        }
+
+        auto sq = static_cast<char *>(_sq_ring);
+        _sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        _sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        _sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        _sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        _sq_entries = params.sq_entries;
+
+        auto cq = static_cast<char *>(_cq_ring);
+        _cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        _cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        _cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    }
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    ~IoUring() {
+        release();
+    }
+
+    unsigned size() const {
+        return _sq_entries;
+    }
+
+    /// Prepare a read into `buffer`, that is started by the next
+    /// submit_and_wait(). Returns false if the submission queue is full
+    bool prepare_read(int fd,
+                      const iovec *buffer,
+                      uint64_t offset,
+                      uint64_t user_data) {
+        auto tail = *_sq_tail;
+        auto head = std::atomic_ref{*_sq_head}.load(std::memory_order_acquire);
+        if (tail - head == _sq_entries) {
+            return false;
+        }
+        auto index = tail & _sq_mask;
+        auto &sqe = _sqes[index];
+        sqe = {};
+        // IORING_OP_READV instead of IORING_OP_READ for older kernels
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        _sq_array[index] = index;
+        std::atomic_ref{*_sq_tail}.store(tail + 1, std::memory_order_release);
+        ++_num_prepared;
+        return true;
+    }
+
+    /// Submit the prepared requests and wait until at least one is complete
+    void submit_and_wait() {
+        while (true) {
+            auto result = syscall(__NR_io_uring_enter,
+                                  _fd,
+                                  _num_prepared,
+                                  1,
+                                  IORING_ENTER_GETEVENTS,
+                                  nullptr,
+                                  0);
+            if (result >= 0) {
+                _num_prepared -= static_cast<unsigned>(result);
+                return;
+            }
+            if (errno != EINTR) {
+                throw std::system_error{
+                    errno, std::system_category(), "io_uring_enter"};
+            }
+        }
+    }
+
+    /// Call `f(user_data, result)` for each completed request, where result
+    /// is the number of bytes or a negative errno
+    template <typename F>
+    void for_each_completion(F f) {
+        auto head = *_cq_head;
+        auto tail = std::atomic_ref{*_cq_tail}.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            auto cqe = _cqes[head & _cq_mask];
+            f(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref{*_cq_head}.store(head, std::memory_order_release);
+    }
+
+private:
+    void release() {
+        if (_sqes) {
+            munmap(_sqes, _sqes_size);
+        }
+        if (_cq_ring && _cq_ring != _sq_ring) {
+            munmap(_cq_ring, _cq_size);
+        }
+        if (_sq_ring) {
+            munmap(_sq_ring, _sq_size);
+        }
+        close(_fd);
+    }
+
+    void *map(size_t size, off_t offset) {
+        auto ptr = mmap(nullptr,
+                        size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        _fd,
+                        offset);
+        if (ptr == MAP_FAILED) {
+            throw std::system_error{errno, std::system_category(), "mmap"};
+        }
+        return ptr;
+    }
+
+    int _fd = -1;
+    void *_sq_ring = nullptr;
+    void *_cq_ring = nullptr;
+    io_uring_sqe *_sqes = nullptr;
+    size_t _sq_size = 0;
+    size_t _cq_size = 0;
+    size_t _sqes_size = 0;
+
+    unsigned *_sq_head = nullptr;
+    unsigned *_sq_tail = nullptr;
+    unsigned *_sq_array = nullptr;
+    unsigned _sq_mask = 0;
+    unsigned _sq_entries = 0;
+    unsigned _num_prepared = 0;
+
+    unsigned *_cq_head = nullptr;
+    unsigned *_cq_tail = nullptr;
+    unsigned _cq_mask = 0;
+    io_uring_cqe *_cqes = nullptr;
+};
+
+/// Read the files with up to ring.size() reads at the same time, and push
+/// them to `contents` in batches of up to `batch_size` as they are completed.
+/// Stops early if `contents` is closed
+inline void read_files(const std::vector<std::filesystem::path> &paths,
+                       IoUring &ring,
+                       BoundedQueue<std::vector<FileContent>> &contents,
+                       size_t batch_size) {
+    struct Slot {
+        size_t index = 0;
+        int fd = -1;
+        std::string text;
+        size_t size_read = 0;
+        iovec buffer = {};
+    };
+
+    auto slots = std::vector<Slot>(ring.size());
+
+    // Close the files that are being read if the ring fails
+    struct CloseSlots {
+        std::vector<Slot> &slots;
+
+        ~CloseSlots() {
+            for (auto &slot : slots) {
+                if (slot.fd >= 0) {
+                    close(slot.fd);
+                }
+            }
+        }
+    } close_slots{slots};
+
+    auto free_slots = std::vector<size_t>{};
+    for (size_t i = slots.size(); i > 0; --i) {
+        free_slots.push_back(i - 1);
+    }
+    size_t next_path = 0;
+    size_t num_in_flight = 0;
+    bool is_stopped = false;
+    auto batch = std::vector<FileContent>{};
+
+    auto submit = [&](size_t id) {
+        auto &slot = slots[id];
+        slot.buffer = {slot.text.data() + slot.size_read,
+                       slot.text.size() - slot.size_read};
+        ring.prepare_read(slot.fd, &slot.buffer, slot.size_read, id);
+    };
+
+    auto flush = [&] {
+        if (!batch.empty() && !is_stopped &&
+            !contents.push(std::move(batch))) {
+            is_stopped = true;
+        }
+        batch.clear();
+    };
+
+    auto push = [&](FileContent content) {
+        batch.push_back(std::move(content));
+        if (batch.size() >= batch_size) {
+            flush();
+        }
+    };
+
+    auto finish = [&](size_t id, std::exception_ptr error) {
+        auto &slot = slots[id];
+        close(slot.fd);
+        slot.fd = -1;
+        if (!error) {
+            // Shorter than expected if the file was truncated while read
+            slot.text.resize(slot.size_read);
+        }
+        push({slot.index, std::move(slot.text), error});
+        free_slots.push_back(id);
+        --num_in_flight;
+    };
+
+    while ((next_path < paths.size() && !is_stopped) || num_in_flight) {
+        while (next_path < paths.size() && !is_stopped &&
+               !free_slots.empty()) {
+            auto index = next_path++;
+            auto &path = paths[index];
+            auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                push({index,
+                      {},
+                      std::make_exception_ptr(std::runtime_error{
+                          "Failed to open " + path.string()})});
+                continue;
+            }
+            struct stat info = {};
+            if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+                info.st_size == 0) {
+                // Pipes and files in /proc have no size, so they are read
+                // as a stream
+                close(fd);
+                auto content = FileContent{};
+                content.index = index;
+                try {
+                    content.text = read_file_content(path);
+                }
+                catch (...) {
+                    content.error = std::current_exception();
+                }
+                push(std::move(content));
+                continue;
+            }
+
+            auto id = free_slots.back();
+            free_slots.pop_back();
+            auto &slot = slots[id];
+            slot.index = index;
+            slot.fd = fd;
+            slot.text.resize(static_cast<size_t>(info.st_size));
+            slot.size_read = 0;
+            submit(id);
+            ++num_in_flight;
+        }
+        if (!num_in_flight) {
+            flush();
+            continue;
+        }
+
+        ring.submit_and_wait();
+        ring.for_each_completion([&](uint64_t id, int result) {
+            auto &slot = slots[id];
+            if (result == -EINTR || result == -EAGAIN) {
+                submit(id);
+            }
+            else if (result < 0) {
+                finish(id,
+                       std::make_exception_ptr(std::runtime_error{
+                           "Failed to read " + paths[slot.index].string() +
+                           ": " + std::strerror(-result)}));
+            }
+            else if (result > 0 &&
+                     (slot.size_read += static_cast<size_t>(result)) <
+                         slot.text.size()) {
+                submit(id);
+            }
+            else {
+                finish(id, {});
+            }
+        });
+        flush();
+    }
+    flush();
+}
+
+#endif
+
+} // namespace json_internal
+
+/// Reads and parses many files at the same time. With io_uring, one thread
+/// keeps `queue_depth` reads in flight, so the time is bound by the device
+/// rather than by the latency of each file, and the parsing threads takes
+/// the files as the reads are completed. Without io_uring, or if it can not
+/// be used, each parsing thread reads the next file with blocking reads.
+///
+/// The results are given by next() in the order that they are completed,
+/// use LoadedFile::index to find the position in `paths`:
+///
+///   auto loader = json::BatchLoader{paths};
+///   while (auto file = loader.next()) {
+///       if (file->document) {
+///           index(file->path, file->document->root());
+///       }
+///   }
+class BatchLoader {
+public:
+    explicit BatchLoader(std::vector<std::filesystem::path> paths,
+                         const BatchLoadOptions &options = {})
+        : _paths{std::move(paths)}
+        , _options{options}
+        , _contents{std::max<size_t>(_options.num_threads, 1) * 2}
+        , _results{std::max<size_t>(_options.num_threads, 1) * 2} {
+        auto num_threads = std::max<size_t>(_options.num_threads, 1);
+        _num_active_workers = num_threads;
+
+#ifdef FAST_JSON_HAS_IO_URING
+        if (_options.use_io_uring && !_paths.empty()) {
+            try {
+                auto entries = std::clamp<size_t>(
+                    std::min(_options.queue_depth, _paths.size()), 1, 4096);
+                _ring = std::make_unique<json_internal::IoUring>(
+                    static_cast<unsigned>(entries));
+            }
+            catch (const std::system_error &) {
+                // For example when io_uring is disabled, or blocked by seccomp
+            }
+        }
+        if (_ring) {
+            _threads.emplace_back([this] { read(); });
+        }
+#endif
+        for (size_t i = 0; i < num_threads; ++i) {
+            _threads.emplace_back([this] { work(); });
+        }
+    }
+
+    BatchLoader(const BatchLoader &) = delete;
+    BatchLoader &operator=(const BatchLoader &) = delete;
+
+    /// Stops the reads and the parsing of the files that are left
+    ~BatchLoader() {
+        _contents.close();
+        _results.close();
+        _threads.clear();
+    }
+
+    /// The next file that is parsed, or nullopt when all are done. Blocks
+    /// until a file is ready
+    std::optional<LoadedFile> next() {
+        while (_next_result == _batch.size()) {
+            _batch.clear();
+            _next_result = 0;
+            if (!_results.pop(_batch)) {
+                return std::nullopt;
+            }
+        }
+        return std::move(_batch[_next_result++]);
+    }
+
+    bool uses_io_uring() const {
+#ifdef FAST_JSON_HAS_IO_URING
+        return static_cast<bool>(_ring);
+#else
+        return false;
+#endif
+    }
+
+private:
+    // The files are passed between the threads in batches, so that the
+    // threads are not woken up for each file
+    static constexpr size_t batch_size = 16;
+
+#ifdef FAST_JSON_HAS_IO_URING
+    void read() {
+        try {
+            json_internal::read_files(_paths, *_ring, _contents, batch_size);
+            _contents.close();
+        }
+        catch (...) {
+            _contents.close(std::current_exception());
+        }
+    }
+#endif
+
+    void work() {
+        try {
+            auto contents = std::vector<json_internal::FileContent>{};
+            while (next_contents(contents)) {
+                auto files = std::vector<LoadedFile>{};
+                files.reserve(contents.size());
+                for (auto &content : contents) {
+                    files.push_back(parse(std::move(content)));
+                }
+                if (!_results.push(std::move(files))) {
+                    break;
+                }
+            }
+            if (--_num_active_workers == 0) {
+                _results.close();
+            }
+        }
+        catch (...) {
+            _results.close(std::current_exception());
+        }
+    }
+
+    /// Take files that are read by io_uring, or read the next ones
+    bool next_contents(std::vector<json_internal::FileContent> &contents) {
+        contents.clear();
+        if (uses_io_uring()) {
+            return _contents.pop(contents);
+        }
+        auto begin = _next_path.fetch_add(batch_size);
+        auto end = std::min(begin + batch_size, _paths.size());
+        for (auto index = begin; index < end; ++index) {
+            auto &content = contents.emplace_back();
+            content.index = index;
+            try {
+                content.text = read_file_content(_paths[index]);
+            }
+            catch (...) {
+                content.error = std::current_exception();
+            }
+        }
+        return !contents.empty();
+    }
+
+    LoadedFile parse(json_internal::FileContent content) {
+        auto file = LoadedFile{};
+        file.index = content.index;
+        file.path = _paths[content.index];
+        file.error = content.error;
+        if (!file.error) {
+            try {
+                file.document = Document::parse(std::move(content.text),
+                                                _options.parse_options);
+            }
+            catch (...) {
+                file.error = std::current_exception();
+            }
+        }
+        return file;
+    }
+
+    std::vector<std::filesystem::path> _paths;
+    BatchLoadOptions _options;
+    json_internal::BoundedQueue<std::vector<json_internal::FileContent>>
+        _contents;
+    json_internal::BoundedQueue<std::vector<LoadedFile>> _results;
+    std::vector<LoadedFile> _batch;
+    size_t _next_result = 0;
+    std::atomic<size_t> _next_path = 0;
+    std::atomic<size_t> _num_active_workers = 0;
+#ifdef FAST_JSON_HAS_IO_URING
+    std::unique_ptr<json_internal::IoUring> _ring;
+#endif
+    // Last, so that the threads are stopped before the rest is destroyed
+    std::vector<std::jthread> _threads;
+};
+
+/// Load all files with a BatchLoader and call `f(LoadedFile &)` on the
+/// calling thread for each, in the order that they are completed
+template <typename F>
+void load_files(std::vector<std::filesystem::path> paths,
+                F f,
+                const BatchLoadOptions &options = {}) {
+    auto loader = BatchLoader{std::move(paths), options};
+    while (auto file = loader.next()) {
+        f(*file);
+    }
+}
+
+} // namespace json
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "jsonnode.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+namespace json_internal {
+
+/// Convert UTF-8 to UTF-16 code units, used to sort keys as RFC 8785 says
+inline std::u16string to_utf16(std::string_view str) {
+    auto res = std::u16string{};
+    res.reserve(str.size());
+    for (size_t i = 0; i < str.size();) {
+        auto c = static_cast<unsigned char>(str[i]);
+        uint32_t code_point = c;
+        size_t length = 1;
+        if (c >= 0xf0) {
+            code_point = c & 0x07;
+            length = 4;
+        }
+        else if (c >= 0xe0) {
+            code_point = c & 0x0f;
+            length = 3;
+        }
+        else if (c >= 0xc0) {
+            code_point = c & 0x1f;
+            length = 2;
+        }
+        for (size_t j = 1; j < length && i + j < str.size(); ++j) {
+            code_point = (code_point << 6) | (str[i + j] & 0x3f);
+        }
+        i += length;
+
+        if (code_point >= 0x10000) {
+            code_point -= 0x10000;
+            res.push_back(static_cast<char16_t>(0xd800 + (code_point >> 10)));
+            res.push_back(static_cast<char16_t>(0xdc00 + (code_point & 0x3ff)));
+        }
+        else {
+            res.push_back(static_cast<char16_t>(code_point));
+        }
+    }
+    return res;
+}
+
+/// Format a number the way ECMAScript does (Number.prototype.toString),
+/// which is what RFC 8785 requires
+inline void write_es_number(double value, std::string &out) {
+    if (!std::isfinite(value)) {
+        throw std::invalid_argument{"number can not be represented in json"};
+    }
+    if (value == 0) {
+        out += "0"; // Also for -0
+        return;
+    }
+    if (value < 0) {
+        out += "-";
+        value = -value;
+    }
+
+    // The shortest digits that round trips, in the form d.ddde±x
+    char buffer[32];
+    auto result = std::to_chars(
+        buffer, buffer + sizeof(buffer), value, std::chars_format::scientific);
+    auto text = std::string_view{buffer, static_cast<size_t>(result.ptr - buffer)};
+    auto e = text.find('e');
+    auto digits = std::string{text.substr(0, e)};
+    std::erase(digits, '.');
+    int exponent = 0;
+    auto exponent_text = text.substr(e + 1);
+    if (exponent_text.front() == '+') {
+        exponent_text.remove_prefix(1);
+    }
+    std::from_chars(exponent_text.data(),
+                    exponent_text.data() + exponent_text.size(),
+                    exponent);
+
+    auto k = static_cast<int>(digits.size());
+    auto n = exponent + 1; // Position of the decimal point
+
+    if (k <= n && n <= 21) {
+        out += digits;
+        out.append(static_cast<size_t>(n - k), '0');
+    }
+    else if (0 < n && n <= 21) {
+        out.append(digits, 0, static_cast<size_t>(n));
+        out += ".";
+        out.append(digits, static_cast<size_t>(n));
+    }
+    else if (-6 < n && n <= 0) {
+        out += "0.";
+        out.append(static_cast<size_t>(-n), '0');
+        out += digits;
+    }
+    else {
+        out += digits.front();
+        if (k > 1) {
+            out += ".";
+            out.append(digits, 1);
+        }
+        out += n - 1 < 0 ? "e-" : "e+";
+        out += std::to_string(std::abs(n - 1));
+    }
+}
+
+} // namespace json_internal
+
+/// Write the canonical form of a value as described by the JSON
+/// Canonicalization Scheme (RFC 8785): no whitespace, object keys sorted by
+/// their UTF-16 code units, numbers formatted as in ECMAScript and strings
+/// with the minimal escaping. Values that are equal gets the same text,
+/// regardless of how they were written
+inline void write_canonical(const JsonNode &node, std::string &out) {
+    using namespace json_internal;
+    switch (node.value().type) {
+    case TokenType::STRING:
+        out += "\"";
+        escape_to(out, node.str());
+        out += "\"";
+        break;
+    case TokenType::NUMBER:
+        write_es_number(node.number<double>(), out);
+        break;
+    case TokenType::BOOLEAN:
+    case TokenType::NULL_VALUE:
+        out += node.value().value;
+        break;
+    case TokenType::BEGIN_ARRAY: {
+        out += "[";
+        bool is_first = true;
+        for (auto &child : node) {
+            if (!is_first) {
+                out += ",";
+            }
+            is_first = false;
+            write_canonical(child, out);
+        }
+        out += "]";
+        break;
+    }
+    case TokenType::BEGIN_OBJECT: {
+        struct Member {
+            std::u16string sort_key;
+            std::string name;
+            const JsonNode *value;
+        };
+        auto members = std::vector<Member>{};
+        members.reserve(node.size());
+        for (auto &key : node) {
+            auto name = JsonNode{Token{TokenType::STRING, key.value().value}}
+                            .str();
+            auto sort_key = to_utf16(name);
+            members.push_back(
+                {std::move(sort_key), std::move(name), key.children()});
+        }
+        std::sort(members.begin(),
+                  members.end(),
+                  [](const Member &a, const Member &b) {
+                      return a.sort_key < b.sort_key;
+                  });
+
+        out += "{";
+        for (auto &member : members) {
+            if (&member != &members.front()) {
+                out += ",";
+            }
+            out += "\"";
+            escape_to(out, member.name);
+            out += "\":";
+            write_canonical(*member.value, out);
+        }
+        out += "}";
+        break;
+    }
+    default:
+        throw std::invalid_argument{"unexpected node in canonical form"};
+    }
+}
+
+inline std::string to_canonical_string(const JsonNode &node) {
+    auto out = std::string{};
+    write_canonical(node, out);
+    return out;
+}
+
+} // namespace json
@@ -0,0 +1,432 @@
+#pragma once
+
+#include "mutabledocument.h"
+#include "schema.h"
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace json {
+
+enum class ColumnType {
+    Double,
+    Int64,
+    Bool,
+    String,
+};
+
+/// A field to extract from each record. `path` is a JSON Pointer to a value
+/// in nested objects and arrays, for example "/user/id" or "/items/0/id".
+/// A token selects a array element only if it is a index without leading
+/// zeros, so "-" or "01" never finds a element
+struct ColumnSpec {
+    std::string path;
+    ColumnType type = ColumnType::Double;
+};
+
+namespace json_internal {
+class ColumnExtractor;
+} // namespace json_internal
+
+/// The values of one field for all records, stored contiguously in the same
+/// way as Apache Arrow: a validity bitmap with one bit per record, and
+/// strings as one buffer of characters with offsets. Records where the value
+/// is missing or null have a cleared validity bit and a zero or empty value
+class Column {
+public:
+    explicit Column(ColumnType type = ColumnType::Double)
+        : _type{type} {}
+
+    ColumnType type() const {
+        return _type;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool is_valid(size_t index) const {
+        return (_validity[index / 64] >> (index % 64)) & 1;
+    }
+
+    bool is_null(size_t index) const {
+        return !is_valid(index);
+    }
+
+    size_t null_count() const {
+        return _null_count;
+    }
+
+    /// Bit i%64 of word i/64 is set for records that has a value
+    std::span<const uint64_t> validity() const {
+        return _validity;
+    }
+
+    std::span<const double> doubles() const {
+        check_type(ColumnType::Double);
+        return _doubles;
+    }
+
+    std::span<const int64_t> int64s() const {
+        check_type(ColumnType::Int64);
+        return _int64s;
+    }
+
+    /// One byte per record, 1 for true
+    std::span<const uint8_t> bools() const {
+        check_type(ColumnType::Bool);
+        return _bools;
+    }
+
+    /// String i is chars()[offsets()[i], offsets()[i + 1])
+    std::span<const uint64_t> offsets() const {
+        check_type(ColumnType::String);
+        return _offsets;
+    }
+
+    std::string_view chars() const {
+        check_type(ColumnType::String);
+        return _chars;
+    }
+
+    std::string_view string(size_t index) const {
+        check_type(ColumnType::String);
+        return std::string_view{_chars}.substr(
+            _offsets.at(index), _offsets.at(index + 1) - _offsets.at(index));
+    }
+
+    /// Add the records of `other` at the end
+    void append(const Column &other) {
+        check_type(other._type);
+        for (size_t i = 0; i < other._size; ++i) {
+            push_validity(other.is_valid(i));
+        }
+        _doubles.insert(
+            _doubles.end(), other._doubles.begin(), other._doubles.end());
+        _int64s.insert(
+            _int64s.end(), other._int64s.begin(), other._int64s.end());
+        _bools.insert(_bools.end(), other._bools.begin(), other._bools.end());
+        auto base = _chars.size();
+        for (size_t i = 1; i < other._offsets.size(); ++i) {
+            _offsets.push_back(base + other._offsets[i]);
+        }
+        _chars += other._chars;
+    }
+
+private:
+    friend class json_internal::ColumnExtractor;
+
+    void check_type(ColumnType type) const {
+        if (type != _type) {
+            throw std::invalid_argument{"column has another type"};
+        }
+    }
+
+    void push_validity(bool is_valid) {
+        if (_size % 64 == 0) {
+            _validity.push_back(0);
+        }
+        if (is_valid) {
+            _validity.back() |= uint64_t{1} << (_size % 64);
+        }
+        else {
+            ++_null_count;
+        }
+        ++_size;
+    }
+
+    void push_null() {
+        push_validity(false);
+        switch (_type) {
+        case ColumnType::Double:
+            _doubles.push_back(0);
+            break;
+        case ColumnType::Int64:
+            _int64s.push_back(0);
+            break;
+        case ColumnType::Bool:
+            _bools.push_back(0);
+            break;
+        case ColumnType::String:
+            _offsets.push_back(_chars.size());
+            break;
+        }
+    }
+
+    ColumnType _type;
+    size_t _size = 0;
+    size_t _null_count = 0;
+    std::vector<uint64_t> _validity;
+    std::vector<double> _doubles;
+    std::vector<int64_t> _int64s;
+    std::vector<uint8_t> _bools;
+    std::vector<uint64_t> _offsets = {0};
+    std::string _chars;
+};
+
+namespace json_internal {
+
+/// The fields to extract as a tree of keys
+struct ColumnPathNode {
+    std::string key;
+    int column = -1;
+    std::vector<std::unique_ptr<ColumnPathNode>> children;
+
+    const ColumnPathNode *find(std::string_view raw_key) const {
+        for (auto &child : children) {
+            if (child->key == raw_key) {
+                return child.get();
+            }
+        }
+        if (raw_key.find('\\') != std::string_view::npos) {
+            auto name = JsonNode{Token{TokenType::STRING, raw_key}}.str();
+            for (auto &child : children) {
+                if (child->key == name) {
+                    return child.get();
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    ColumnPathNode &add(std::string name) {
+        for (auto &child : children) {
+            if (child->key == name) {
+                return *child;
+            }
+        }
+        children.push_back(std::make_unique<ColumnPathNode>());
+        children.back()->key = std::move(name);
+        return *children.back();
+    }
+};
+
+inline ColumnPathNode build_column_paths(std::span<const ColumnSpec> specs) {
+    auto root = ColumnPathNode{};
+    for (size_t i = 0; i < specs.size(); ++i) {
+        auto pointer = std::string_view{specs[i].path};
+        if (pointer.empty() || pointer.front() != '/') {
+            throw std::invalid_argument{"json pointer must start with '/': " +
+                                        specs[i].path};
+        }
+        auto *node = &root;
+        while (!pointer.empty()) {
+            pointer.remove_prefix(1);
+            auto end = pointer.find('/');
+            node = &node->add(unescape_reference(pointer.substr(0, end)));
+            pointer.remove_prefix(std::min(end, pointer.size()));
+        }
+        if (node->column >= 0) {
+            throw std::invalid_argument{"path is extracted twice: " +
+                                        specs[i].path};
+        }
+        node->column = static_cast<int>(i);
+    }
+    return root;
+}
+
+/// Reads records with a SchemaReader and appends the selected values to the
+/// columns. Only the keys on the paths are looked at, everything else is
+/// skipped without being parsed
+class ColumnExtractor {
+public:
+    ColumnExtractor(const ColumnPathNode &paths, std::vector<Column> &columns)
+        : _paths{paths}
+        , _columns{columns} {}
+
+    void read_record(SchemaReader &reader) {
+        auto row = _columns.empty() ? 0 : _columns.front().size();
+        read_object(reader, _paths, row);
+        for (auto &column : _columns) {
+            if (column.size() == row) {
+                column.push_null();
+            }
+        }
+    }
+
+private:
+    void read_object(SchemaReader &reader,
+                     const ColumnPathNode &node,
+                     size_t row) {
+        if (reader.peek() != '{') {
+            reader.error("expected object");
+        }
+        reader.expect('{');
+        if (reader.consume('}')) {
+            return;
+        }
+        do {
+            auto key = reader.read_raw_string();
+            reader.expect(':');
+            read_member(reader, node.find(key), row);
+        } while (reader.consume(','));
+        reader.expect('}');
+    }
+
+    void read_array(SchemaReader &reader,
+                    const ColumnPathNode &node,
+                    size_t row) {
+        reader.expect('[');
+        if (reader.consume(']')) {
+            return;
+        }
+        size_t index = 0;
+        do {
+            read_member(reader, node.find(std::to_string(index++)), row);
+        } while (reader.consume(','));
+        reader.expect(']');
+    }
+
+    /// Read the value of a key or element, where `child` is its path node or
+    /// null if it is not on a path
+    void read_member(SchemaReader &reader,
+                     const ColumnPathNode *child,
+                     size_t row) {
+        if (!child) {
+            reader.skip_value();
+        }
+        else if (child->column >= 0 && _columns[child->column].size() == row) {
+            read_value(reader, _columns[child->column]);
+        }
+        else if (!child->children.empty() && reader.peek() == '{') {
+            read_object(reader, *child, row);
+        }
+        else if (!child->children.empty() && reader.peek() == '[') {
+            read_array(reader, *child, row);
+        }
+        else {
+            // Duplicated keys: the first value is used as by find()
+            reader.skip_value();
+        }
+    }
+
+    static void read_value(SchemaReader &reader, Column &column) {
+        if (reader.consume_null()) {
+            column.push_null();
+            return;
+        }
+        column.push_validity(true);
+        switch (column._type) {
+        case ColumnType::Double:
+            reader.read(column._doubles.emplace_back());
+            break;
+        case ColumnType::Int64:
+            reader.read(column._int64s.emplace_back());
+            break;
+        case ColumnType::Bool: {
+            auto value = false;
+            reader.read(value);
+            column._bools.push_back(value);
+            break;
+        }
+        case ColumnType::String:
+            if (reader.peek() != '\"') {
+                reader.error("expected string");
+            }
+            JsonNode{Token{TokenType::STRING, reader.read_raw_string()}}
+                .unescape_to(column._chars);
+            column._offsets.push_back(column._chars.size());
+            break;
+        }
+    }
+
+    const ColumnPathNode &_paths;
+    std::vector<Column> &_columns;
+};
+
+inline void extract_records(std::string_view input,
+                            size_t begin,
+                            size_t end,
+                            const ColumnPathNode &paths,
+                            std::vector<Column> &columns) {
+    // The reader sees the text before `begin` so that errors gets the right
+    // location
+    auto reader = SchemaReader{input.substr(0, end), begin};
+    auto extractor = ColumnExtractor{paths, columns};
+    while (reader.peek()) {
+        extractor.read_record(reader);
+    }
+}
+
+} // namespace json_internal
+
+/// Extract fields from each record of NDJSON text into typed columns, one
+/// for each spec and in the same order. No tree is built for the records:
+/// the text is scanned once and only the values on the paths are converted.
+///
+/// With `num_threads` > 1 the input is split at newlines into parts that are
+/// extracted at the same time and then appended. Records must then be on one
+/// line each as NDJSON requires. A value of the wrong type, or a record that
+/// is not a object, throws ParseError
+inline std::vector<Column> extract_columns(std::string_view input,
+                                           std::span<const ColumnSpec> specs,
+                                           size_t num_threads = 1) {
+    auto paths = json_internal::build_column_paths(specs);
+    auto make_columns = [&] {
+        auto columns = std::vector<Column>{};
+        columns.reserve(specs.size());
+        for (auto &spec : specs) {
+            columns.emplace_back(spec.type);
+        }
+        return columns;
+    };
+
+    // Split at newlines into parts of about the same size
+    auto bounds = std::vector<size_t>{0};
+    for (size_t i = 1; i < std::max<size_t>(num_threads, 1); ++i) {
+        auto pos = input.find('\n', std::max(input.size() * i / num_threads,
+                                             bounds.back()));
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(input.size());
+
+    auto parts = std::vector<std::vector<Column>>(bounds.size() - 1);
+    if (parts.size() == 1) {
+        parts.front() = make_columns();
+        json_internal::extract_records(
+            input, 0, input.size(), paths, parts.front());
+        return std::move(parts.front());
+    }
+
+    auto errors = std::vector<std::exception_ptr>(parts.size());
+    {
+        auto threads = std::vector<std::jthread>{};
+        for (size_t i = 0; i < parts.size(); ++i) {
+            threads.emplace_back([&, i] {
+                try {
+                    parts[i] = make_columns();
+                    json_internal::extract_records(
+                        input, bounds[i], bounds[i + 1], paths, parts[i]);
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    auto columns = std::move(parts.front());
+    for (size_t i = 1; i < parts.size(); ++i) {
+        for (size_t j = 0; j < columns.size(); ++j) {
+            columns[j].append(parts[i][j]);
+        }
+    }
+    return columns;
+}
+
+} // namespace json
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "json.h"
+#include "queue.h"
+#include "splitter.h"
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// FAST_JSON_HAS_ZLIB and FAST_JSON_HAS_ZSTD are defined by CMake when the
+// libraries are found
+#ifdef FAST_JSON_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FAST_JSON_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace json {
+
+enum class Compression {
+    None,
+    Gzip,
+    Zstd,
+};
+
+/// Find the compression from the first bytes of a file
+inline Compression detect_compression(std::string_view header) {
+    if (header.size() >= 2 && header[0] == '\x1f' && header[1] == '\x8b') {
+        return Compression::Gzip;
+    }
+    if (header.size() >= 4 && header.substr(0, 4) == "\x28\xb5\x2f\xfd") {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+/// Reads a file that may be compressed with gzip or zstd, a piece at a time.
+/// Only the piece of compressed data that is currently decompressed is kept
+/// in memory. Files that is not compressed are read as they are
+class DecompressingReader {
+public:
+    explicit DecompressingReader(const std::filesystem::path &path,
+                                 size_t input_size = 64 * 1024)
+        : _file{path, std::ios::binary}
+        , _input(input_size) {
+        if (!_file.is_open()) {
+            throw std::runtime_error{"Failed to open " + path.string()};
+        }
+        fill_input();
+        _compression = detect_compression({_input.data(), _input_size});
+
+        switch (_compression) {
+        case Compression::None:
+            break;
+        case Compression::Gzip:
+#ifdef FAST_JSON_HAS_ZLIB
+            _zlib = {};
+            // 16 + 15: gzip header and the largest window
+            if (inflateInit2(&_zlib, 16 + 15) != Z_OK) {
+                throw std::runtime_error{"Failed to initialize zlib"};
+            }
+            _zlib_active = true;
+            break;
+#else
+            throw std::runtime_error{path.string() +
+                                     " is gzip compressed, but fast-json is "
+                                     "built without zlib"};
+#endif
+        case Compression::Zstd:
+#ifdef FAST_JSON_HAS_ZSTD
+            _zstd = ZSTD_createDStream();
+            if (!_zstd) {
+                throw std::runtime_error{"Failed to initialize zstd"};
+            }
+            break;
+#else
+            throw std::runtime_error{path.string() +
+                                     " is zstd compressed, but fast-json is "
+                                     "built without zstd"};
+#endif
+        }
+    }
+
+    DecompressingReader(const DecompressingReader &) = delete;
+    DecompressingReader &operator=(const DecompressingReader &) = delete;
+
+    ~DecompressingReader() {
+#ifdef FAST_JSON_HAS_ZLIB
+        if (_zlib_active) {
+            inflateEnd(&_zlib);
+        }
+#endif
+#ifdef FAST_JSON_HAS_ZSTD
+        if (_zstd) {
+            ZSTD_freeDStream(_zstd);
+        }
+#endif
+    }
+
+    Compression compression() const {
+        return _compression;
+    }
+
+    /// Decompress into `buffer`. Returns the number of bytes written, 0 at
+    /// the end of the file
+    size_t read(std::span<char> buffer) {
+        if (buffer.empty()) {
+            return 0;
+        }
+        switch (_compression) {
+        case Compression::Gzip:
+            return read_gzip(buffer);
+        case Compression::Zstd:
+            return read_zstd(buffer);
+        default:
+            return read_plain(buffer);
+        }
+    }
+
+private:
+    /// Move the unused input to the front and read more from the file
+    void fill_input() {
+        if (_input_pos) {
+            std::memmove(_input.data(),
+                         _input.data() + _input_pos,
+                         _input_size - _input_pos);
+            _input_size -= _input_pos;
+            _input_pos = 0;
+        }
+        if (_file) {
+            auto size = _input.size() - _input_size;
+            _file.read(_input.data() + _input_size,
+                       static_cast<std::streamsize>(size));
+            _input_size += static_cast<size_t>(_file.gcount());
+        }
+    }
+
+    bool is_input_empty() const {
+        return _input_pos == _input_size;
+    }
+
+    size_t read_plain(std::span<char> buffer) {
+        if (is_input_empty()) {
+            fill_input();
+        }
+        auto size = std::min(buffer.size(), _input_size - _input_pos);
+        std::memcpy(buffer.data(), _input.data() + _input_pos, size);
+        _input_pos += size;
+        return size;
+    }
+
+    size_t read_gzip([[maybe_unused]] std::span<char> buffer) {
+#ifdef FAST_JSON_HAS_ZLIB
+        _zlib.next_out = reinterpret_cast<Bytef *>(buffer.data());
+        _zlib.avail_out = static_cast<uInt>(buffer.size());
+        while (_zlib.avail_out) {
+            if (is_input_empty()) {
+                fill_input();
+                if (is_input_empty()) {
+                    if (!_is_stream_end) {
+                        throw std::runtime_error{"Truncated gzip data"};
+                    }
+                    break;
+                }
+            }
+            if (_is_stream_end) {
+                // A file can contain several gzip members after each other
+                inflateReset(&_zlib);
+                _is_stream_end = false;
+            }
+            _zlib.next_in =
+                reinterpret_cast<Bytef *>(_input.data() + _input_pos);
+            _zlib.avail_in = static_cast<uInt>(_input_size - _input_pos);
+            auto result = inflate(&_zlib, Z_NO_FLUSH);
+            _input_pos = _input_size - _zlib.avail_in;
+            if (result == Z_STREAM_END) {
+                _is_stream_end = true;
+            }
+            else if (result != Z_OK && result != Z_BUF_ERROR) {
+                throw std::runtime_error{"Invalid gzip data"};
+            }
+        }
+        return buffer.size() - _zlib.avail_out;
+#else
+        return 0;
+#endif
+    }
+
+    size_t read_zstd([[maybe_unused]] std::span<char> buffer) {
+#ifdef FAST_JSON_HAS_ZSTD
+        auto output = ZSTD_outBuffer{buffer.data(), buffer.size(), 0};
+        while (output.pos < output.size) {
+            if (is_input_empty()) {
+                fill_input();
+                if (is_input_empty()) {
+                    if (!_is_stream_end) {
+                        throw std::runtime_error{"Truncated zstd data"};
+                    }
+                    break;
+                }
+            }
+            auto input = ZSTD_inBuffer{
+                _input.data() + _input_pos, _input_size - _input_pos, 0};
+            auto result = ZSTD_decompressStream(_zstd, &output, &input);
+            _input_pos += input.pos;
+            if (ZSTD_isError(result)) {
+                throw std::runtime_error{std::string{"Invalid zstd data: "} +
+                                         ZSTD_getErrorName(result)};
+            }
+            _is_stream_end = result == 0;
+        }
+        return output.pos;
+#else
+        return 0;
+#endif
+    }
+
+    std::ifstream _file;
+    std::vector<char> _input;
+    size_t _input_pos = 0;
+    size_t _input_size = 0;
+    Compression _compression = Compression::None;
+    bool _is_stream_end = false;
+
+#ifdef FAST_JSON_HAS_ZLIB
+    z_stream _zlib = {};
+    bool _zlib_active = false;
+#endif
+#ifdef FAST_JSON_HAS_ZSTD
+    ZSTD_DStream *_zstd = nullptr;
+#endif
+};
+
+namespace json_internal {
+
+/// Decompress `path` on a separate thread and call `f` with each chunk on the
+/// calling thread
+template <typename F>
+void for_each_decompressed_chunk(const std::filesystem::path &path,
+                                 F f,
+                                 size_t chunk_size,
+                                 size_t max_queued_chunks) {
+    auto queue = BoundedQueue<std::string>{max_queued_chunks};
+    auto reader = DecompressingReader{path};
+
+    auto producer = std::jthread{[&] {
+        try {
+            while (true) {
+                auto chunk = std::string(chunk_size, '\0');
+                chunk.resize(reader.read(chunk));
+                if (chunk.empty() || !queue.push(std::move(chunk))) {
+                    break;
+                }
+            }
+            queue.close();
+        }
+        catch (...) {
+            queue.close(std::current_exception());
+        }
+    }};
+
+    try {
+        auto chunk = std::string{};
+        while (queue.pop(chunk)) {
+            f(std::string_view{chunk});
+        }
+    }
+    catch (...) {
+        // Stop the producer before it is joined
+        queue.close();
+        throw;
+    }
+}
+
+} // namespace json_internal
+
+/// Read a file that may be compressed with gzip or zstd
+inline std::string read_decompressed_content(
+    const std::filesystem::path &path) {
+    auto reader = DecompressingReader{path};
+    auto buffer = std::string{};
+    constexpr size_t chunk_size = 256 * 1024;
+    while (true) {
+        auto old_size = buffer.size();
+        buffer.resize(old_size + chunk_size);
+        auto size = reader.read({buffer.data() + old_size, chunk_size});
+        buffer.resize(old_size + size);
+        if (!size) {
+            return buffer;
+        }
+    }
+}
+
+/// Parse each record in a file that may be compressed with gzip or zstd, and
+/// call `f` with the JsonNode of each. The file is decompressed on a separate
+/// thread while the records are parsed on the calling thread, and only the
+/// records that are not yet parsed are kept in memory. The node passed to `f`
+/// is only valid during the call
+template <typename F>
+void for_each_compressed_record(const std::filesystem::path &path,
+                                F f,
+                                SplitMode mode = SplitMode::Values,
+                                const ParseOptions &options = {},
+                                size_t chunk_size = 256 * 1024,
+                                size_t max_queued_chunks = 4) {
+    auto buffer = std::string{};
+    auto splitter = RecordSplitter{mode};
+    auto parse = [&](std::string_view record) {
+        auto root = parse_json(record, options);
+        f(*root);
+    };
+
+    json_internal::for_each_decompressed_chunk(
+        path,
+        [&](std::string_view chunk) {
+            if (splitter.is_done()) {
+                return;
+            }
+            buffer += chunk;
+            for (auto record = splitter.next(buffer); !record.empty();
+                 record = splitter.next(buffer)) {
+                parse(record);
+            }
+            auto consumed = splitter.consumed();
+            buffer.erase(0, consumed);
+            splitter.discard(consumed);
+        },
+        chunk_size,
+        max_queued_chunks);
+
+    for (auto record = splitter.next(buffer); !record.empty();
+         record = splitter.next(buffer)) {
+        parse(record);
+    }
+    if (auto record = splitter.finish(buffer); !record.empty()) {
+        parse(record);
+    }
+}
+
+} // namespace json
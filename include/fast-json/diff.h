@@ -0,0 +1,242 @@
+#pragma once
+
+#include "hash.h"
+#include "mutabledocument.h"
+#include "writer.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace json {
+
+/// One difference found by diff(), in the form of a JSON Patch operation
+struct Change {
+    enum class Type {
+        Add,
+        Remove,
+        Replace,
+    };
+
+    Type type;
+
+    /// JSON Pointer to the changed value
+    std::string path;
+
+    /// The new value for Add and Replace
+    const JsonNode *value = nullptr;
+};
+
+namespace json_internal {
+
+/// Compares two trees. Subtrees with the same hash are skipped without
+/// looking further at their content. With hash caches that are kept between
+/// calls (for example for successive snapshots) the work depends on the size
+/// of the changes
+class Differ {
+public:
+    Differ(std::vector<Change> &changes, HashCache *cache_a, HashCache *cache_b)
+        : _changes{changes}
+        , _cache_a{cache_a}
+        , _cache_b{cache_b} {}
+
+    void diff(const JsonNode &a, const JsonNode &b, std::string &path) {
+        auto type = a.value().type;
+        if (type != b.value().type) {
+            replace(path, b);
+            return;
+        }
+        if (type != TokenType::BEGIN_ARRAY && type != TokenType::BEGIN_OBJECT) {
+            if (!equal(a, b)) {
+                replace(path, b);
+            }
+            return;
+        }
+        if (hash_a(a) == hash_b(b)) {
+            return;
+        }
+        if (type == TokenType::BEGIN_ARRAY) {
+            diff_array(a, b, path);
+        }
+        else {
+            diff_object(a, b, path);
+        }
+    }
+
+private:
+    uint64_t hash_a(const JsonNode &node) {
+        return structural_hash(node, _cache_a);
+    }
+
+    uint64_t hash_b(const JsonNode &node) {
+        return structural_hash(node, _cache_b);
+    }
+
+    bool is_same(const JsonNode &a, const JsonNode &b) {
+        return a.value().type == b.value().type && hash_a(a) == hash_b(b);
+    }
+
+    void replace(const std::string &path, const JsonNode &value) {
+        _changes.push_back({Change::Type::Replace, path, &value});
+    }
+
+    void diff_array(const JsonNode &a, const JsonNode &b, std::string &path) {
+        auto ea = a.elements();
+        auto eb = b.elements();
+
+        // Skip the equal elements at the start and at the end
+        size_t prefix = 0;
+        while (prefix < ea.size() && prefix < eb.size() &&
+               is_same(ea[prefix], eb[prefix])) {
+            ++prefix;
+        }
+        size_t suffix = 0;
+        while (suffix < ea.size() - prefix && suffix < eb.size() - prefix &&
+               is_same(ea[ea.size() - 1 - suffix], eb[eb.size() - 1 - suffix])) {
+            ++suffix;
+        }
+
+        auto size_a = ea.size() - prefix - suffix;
+        auto size_b = eb.size() - prefix - suffix;
+        auto common = std::min(size_a, size_b);
+        auto path_size = path.size();
+
+        for (size_t i = prefix; i < prefix + common; ++i) {
+            path += "/" + std::to_string(i);
+            diff(ea[i], eb[i], path);
+            path.resize(path_size);
+        }
+
+        // Remove from the back so that the indices stays valid
+        for (auto i = prefix + size_a; i-- > prefix + common;) {
+            _changes.push_back(
+                {Change::Type::Remove, path + "/" + std::to_string(i)});
+        }
+        for (auto i = prefix + common; i < prefix + size_b; ++i) {
+            _changes.push_back(
+                {Change::Type::Add, path + "/" + std::to_string(i), &eb[i]});
+        }
+    }
+
+    void diff_object(const JsonNode &a, const JsonNode &b, std::string &path) {
+        // Large objects are matched through a index of the keys
+        constexpr size_t min_indexed_size = 16;
+        auto index = std::unordered_map<std::string_view, const JsonNode *>{};
+        if (b.size() >= min_indexed_size) {
+            index.reserve(b.size());
+            for (auto &key : b) {
+                index.emplace(key.value().value, &key);
+            }
+        }
+        auto find = [&](const JsonNode &object, std::string_view name)
+            -> const JsonNode * {
+            if (&object == &b && !index.empty()) {
+                auto it = index.find(name);
+                return it == index.end() ? nullptr : it->second;
+            }
+            for (auto &key : object) {
+                if (key.value().value == name) {
+                    return &key;
+                }
+            }
+            return nullptr;
+        };
+
+        auto path_size = path.size();
+        size_t num_found = 0;
+        for (auto &key : a) {
+            auto name = key.value().value;
+            append_pointer_token(path, name);
+            if (auto other = find(b, name)) {
+                ++num_found;
+                diff(*key.children(), *other->children(), path);
+            }
+            else {
+                _changes.push_back({Change::Type::Remove, path});
+            }
+            path.resize(path_size);
+        }
+
+        if (num_found == b.size()) {
+            return;
+        }
+        auto index_a = std::unordered_map<std::string_view, const JsonNode *>{};
+        if (a.size() >= min_indexed_size) {
+            index_a.reserve(a.size());
+            for (auto &key : a) {
+                index_a.emplace(key.value().value, &key);
+            }
+        }
+        for (auto &key : b) {
+            auto name = key.value().value;
+            auto is_in_a = index_a.empty() ? a.find(name) != nullptr
+                                           : index_a.contains(name);
+            if (!is_in_a) {
+                append_pointer_token(path, name);
+                _changes.push_back({Change::Type::Add, path, key.children()});
+                path.resize(path_size);
+            }
+        }
+    }
+
+    std::vector<Change> &_changes;
+    HashCache *_cache_a;
+    HashCache *_cache_b;
+};
+
+} // namespace json_internal
+
+/// The changes needed to turn `a` into `b`. Object members are matched by
+/// key and array elements by position, after equal elements at the start
+/// and end of the arrays have been skipped. The values refers to nodes in
+/// `b`.
+///
+/// The caches are optional. When `b` is diffed against the next version, its
+/// cache can be passed as `cache_a` so that its subtrees is not hashed again
+inline std::vector<Change> diff(const JsonNode &a,
+                                const JsonNode &b,
+                                HashCache *cache_a = nullptr,
+                                HashCache *cache_b = nullptr) {
+    auto changes = std::vector<Change>{};
+    auto path = std::string{};
+    json_internal::Differ{changes, cache_a, cache_b}.diff(a, b, path);
+    return changes;
+}
+
+/// Write changes as a JSON Patch (RFC 6902) document
+inline void write_patch(const std::vector<Change> &changes, std::string &out) {
+    out += "[";
+    for (auto &change : changes) {
+        if (&change != &changes.front()) {
+            out += ",";
+        }
+        switch (change.type) {
+        case Change::Type::Add:
+            out += R"({"op":"add","path":")";
+            break;
+        case Change::Type::Remove:
+            out += R"({"op":"remove","path":")";
+            break;
+        case Change::Type::Replace:
+            out += R"({"op":"replace","path":")";
+            break;
+        }
+        json_internal::escape_to(out, change.path);
+        out += "\"";
+        if (change.value) {
+            out += ",\"value\":";
+            write_json(*change.value, out);
+        }
+        out += "}";
+    }
+    out += "]";
+}
+
+/// Create a JSON Patch that turns `a` into `b`
+inline std::string diff_patch(const JsonNode &a, const JsonNode &b) {
+    auto out = std::string{};
+    write_patch(diff(a, b), out);
+    return out;
+}
+
+} // namespace json
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "json.h"
+#include "splitter.h"
+#include "utils.h"
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/// Input that is shared by the documents that are parsed from it, for
+/// example all records of a NDJSON file. It is freed with the last document
+using SharedBuffer = std::shared_ptr<const std::string>;
+
+/// A parsed document that owns its text, or a part of a SharedBuffer. It can
+/// not be changed after it is created, so any number of threads can read it
+/// at the same time. Share it with std::shared_ptr<const Document> (see
+/// Document::parse()), or use NodeRef to share a value in it
+class Document {
+public:
+    /// Use Document::parse() to get a shared document
+    explicit Document(std::string text, const ParseOptions &options = {})
+        : _owned_text{std::move(text)}
+        , _text{_owned_text}
+        , _root{parse_json(_text, options)} {}
+
+    /// Parse `text`, that is a part of `buffer`, without copying it
+    Document(SharedBuffer buffer,
+             std::string_view text,
+             const ParseOptions &options = {})
+        : _buffer{std::move(buffer)}
+        , _text{check_in_buffer(_buffer, text)}
+        , _root{parse_json(_text, options)} {}
+
+    // The nodes refers to the text, so the document stays where it is
+    Document(const Document &) = delete;
+    Document &operator=(const Document &) = delete;
+
+    static std::shared_ptr<const Document> parse(
+        std::string text, const ParseOptions &options = {}) {
+        return std::make_shared<const Document>(std::move(text), options);
+    }
+
+    static std::shared_ptr<const Document> parse(
+        SharedBuffer buffer,
+        std::string_view text,
+        const ParseOptions &options = {}) {
+        return std::make_shared<const Document>(
+            std::move(buffer), text, options);
+    }
+
+    /// Parse each record in the buffer (see RecordSplitter) into a document
+    /// that shares the buffer
+    static std::vector<std::shared_ptr<const Document>> parse_records(
+        const SharedBuffer &buffer,
+        SplitMode mode = SplitMode::Values,
+        const ParseOptions &options = {}) {
+        auto documents = std::vector<std::shared_ptr<const Document>>{};
+        auto splitter = RecordSplitter{mode};
+        while (true) {
+            auto record = splitter.next(*buffer);
+            if (record.empty()) {
+                record = splitter.finish(*buffer);
+                if (record.empty()) {
+                    break;
+                }
+            }
+            documents.push_back(parse(buffer, record, options));
+        }
+        return documents;
+    }
+
+    static std::shared_ptr<const Document> load(
+        const std::filesystem::path &path, const ParseOptions &options = {}) {
+        return parse(read_file_content(path), options);
+    }
+
+    const JsonNode &root() const {
+        return *_root;
+    }
+
+    const JsonNode *operator->() const {
+        return _root.operator->();
+    }
+
+    const JsonNode &operator*() const {
+        return *_root;
+    }
+
+    const JsonNode &operator[](std::string_view name) const {
+        return _root[name];
+    }
+
+    std::string_view text() const {
+        return _text;
+    }
+
+    /// The buffer that the text is in, or null if the document owns its text
+    const SharedBuffer &buffer() const {
+        return _buffer;
+    }
+
+private:
+    static std::string_view check_in_buffer(const SharedBuffer &buffer,
+                                            std::string_view text) {
+        if (!buffer || text.data() < buffer->data() ||
+            text.data() + text.size() > buffer->data() + buffer->size()) {
+            throw std::invalid_argument{"text is not in the buffer"};
+        }
+        return text;
+    }
+
+    std::string _owned_text;
+    SharedBuffer _buffer;
+    std::string_view _text;
+    JsonRoot _root;
+};
+
+/// A handle to a value in a Document, that keeps the document, and the
+/// buffer it was parsed from, alive. Copying it only changes a reference
+/// count, so values can be passed between threads and stored without
+/// copying the data or keeping track of where it came from
+class NodeRef {
+public:
+    NodeRef() = default;
+
+    /// The root of the document
+    NodeRef(std::shared_ptr<const Document> document) {
+        if (document) {
+            auto &root = document->root();
+            _node = std::shared_ptr<const JsonNode>{std::move(document), &root};
+        }
+    }
+
+    /// `node` must be in `document`
+    NodeRef(std::shared_ptr<const Document> document, const JsonNode &node)
+        : _node{std::move(document), &node} {}
+
+    /// A handle to another value in the same document
+    NodeRef share(const JsonNode &node) const {
+        return NodeRef{_node, &node};
+    }
+
+    NodeRef at(std::string_view name) const {
+        return share(_node->at(name));
+    }
+
+    NodeRef operator[](std::string_view name) const {
+        return at(name);
+    }
+
+    NodeRef at(size_t index) const {
+        return share(_node->at(index));
+    }
+
+    NodeRef operator[](size_t index) const {
+        return at(index);
+    }
+
+    /// A null handle if there is no value with the name
+    NodeRef find(std::string_view name) const {
+        auto node = _node->find(name);
+        return node ? share(*node) : NodeRef{};
+    }
+
+    const JsonNode &operator*() const {
+        return *_node;
+    }
+
+    const JsonNode *operator->() const {
+        return _node.get();
+    }
+
+    const JsonNode *get() const {
+        return _node.get();
+    }
+
+    explicit operator bool() const {
+        return static_cast<bool>(_node);
+    }
+
+    /// The value as a shared pointer that owns the document
+    const std::shared_ptr<const JsonNode> &shared() const {
+        return _node;
+    }
+
+private:
+    NodeRef(const std::shared_ptr<const JsonNode> &owner, const JsonNode *node)
+        : _node{owner, node} {}
+
+    std::shared_ptr<const JsonNode> _node;
+};
+
+/// The current version of a document, that can be replaced while other
+/// threads are reading it. Readers take a snapshot with load() and keep using
+/// it for as long as they like; a new version is parsed on the side and
+/// published with store() or reload() without waiting for the readers. The
+/// old version is freed when the last snapshot of it is released
+class AtomicDocument {
+public:
+    AtomicDocument() = default;
+
+    explicit AtomicDocument(std::shared_ptr<const Document> document)
+        : _current{std::move(document)} {}
+
+    AtomicDocument(const AtomicDocument &) = delete;
+    AtomicDocument &operator=(const AtomicDocument &) = delete;
+
+    /// A snapshot of the current version
+    std::shared_ptr<const Document> load() const {
+        return _current.load(std::memory_order_acquire);
+    }
+
+    void store(std::shared_ptr<const Document> document) {
+        _current.store(std::move(document), std::memory_order_release);
+    }
+
+    /// Publish a new version and return the previous
+    std::shared_ptr<const Document> exchange(
+        std::shared_ptr<const Document> document) {
+        return _current.exchange(std::move(document),
+                                 std::memory_order_acq_rel);
+    }
+
+    /// Parse the text on the calling thread and publish the result. If the
+    /// parsing fails the current version is kept and the error is rethrown
+    void reload(std::string text, const ParseOptions &options = {}) {
+        store(Document::parse(std::move(text), options));
+    }
+
+    void reload_file(const std::filesystem::path &path,
+                     const ParseOptions &options = {}) {
+        store(Document::load(path, options));
+    }
+
+private:
+    std::atomic<std::shared_ptr<const Document>> _current;
+};
+
+} // namespace json
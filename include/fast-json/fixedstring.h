@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+namespace json {
+
+/// A string literal that can be used as a template argument, for example
+/// `field<"name", &Person::name>`
+template <size_t N>
+struct fixed_string {
+    constexpr fixed_string(const char (&str)[N]) {
+        std::copy_n(str, N, data);
+    }
+
+    constexpr std::string_view view() const {
+        return {data, N - 1};
+    }
+
+    constexpr size_t size() const {
+        return N - 1;
+    }
+
+    char data[N] = {};
+};
+
+} // namespace json
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "simd.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace json {
+
+namespace json_internal {
+
+/// Reformat json text without building any nodes. The input can be fed in
+/// chunks of any size, strings and whitespace may be split between chunks.
+/// A negative indent means that the result is minified
+class Reformatter {
+public:
+    explicit Reformatter(int indent)
+        : _indent{indent} {}
+
+    void feed(std::string_view chunk, std::string &out) {
+        auto p = chunk.data();
+        auto end = p + chunk.size();
+
+        while (p != end) {
+            if (_is_in_string) {
+                p = copy_string(p, end, out);
+            }
+            else if (_indent < 0) {
+                auto q = find_any<' ', '\n', '\r', '\t', '\"'>(p, end);
+                out.append(p, q);
+                p = q;
+                if (p == end) {
+                    break;
+                }
+                if (*p == '\"') {
+                    out.push_back('\"');
+                    _is_in_string = true;
+                    ++p;
+                }
+                else {
+                    p = skip_whitespace(p, end);
+                }
+            }
+            else {
+                p = pretty(p, end, out);
+            }
+        }
+    }
+
+    /// Check that the input was complete
+    void finish() {
+        if (_is_in_string) {
+            throw std::runtime_error{"Unterminated string"};
+        }
+    }
+
+private:
+    const char *copy_string(const char *p, const char *end, std::string &out) {
+        if (_is_escaped) {
+            out.push_back(*p);
+            _is_escaped = false;
+            return p + 1;
+        }
+        auto q = find_any<'\"', '\\'>(p, end);
+        out.append(p, q);
+        if (q == end) {
+            return q;
+        }
+        out.push_back(*q);
+        if (*q == '\\') {
+            _is_escaped = true;
+        }
+        else {
+            _is_in_string = false;
+        }
+        return q + 1;
+    }
+
+    const char *pretty(const char *p, const char *end, std::string &out) {
+        p = skip_whitespace(p, end);
+        if (p == end) {
+            return p;
+        }
+
+        auto c = *p;
+        if (_is_pending_open) {
+            _is_pending_open = false;
+            if (c == '}' || c == ']') {
+                // Keep empty containers on one line
+                --_depth;
+                out.push_back(c);
+                return p + 1;
+            }
+            new_line(out);
+        }
+
+        switch (c) {
+        case '{':
+        case '[':
+            out.push_back(c);
+            ++_depth;
+            _is_pending_open = true;
+            return p + 1;
+        case '}':
+        case ']':
+            --_depth;
+            new_line(out);
+            out.push_back(c);
+            return p + 1;
+        case ',':
+            out.push_back(',');
+            new_line(out);
+            return p + 1;
+        case ':':
+            out += ": ";
+            return p + 1;
+        case '\"':
+            out.push_back('\"');
+            _is_in_string = true;
+            return p + 1;
+        default: {
+            auto q = find_any<' ', '\n', '\r', '\t', '\"', '{', '}', '[', ']',
+                              ',', ':'>(p, end);
+            out.append(p, q);
+            return q;
+        }
+        }
+    }
+
+    void new_line(std::string &out) {
+        out.push_back('\n');
+        if (_depth > 0) {
+            out.append(static_cast<size_t>(_depth * _indent), ' ');
+        }
+    }
+
+    int _indent = 2;
+    int _depth = 0;
+    bool _is_in_string = false;
+    bool _is_escaped = false;
+    bool _is_pending_open = false;
+};
+
+inline void reformat(std::istream &in, std::ostream &out, int indent) {
+    constexpr size_t chunk_size = 1 << 16;
+    auto buffer = std::string(chunk_size, '\0');
+    auto result = std::string{};
+    result.reserve(chunk_size * 2);
+    auto formatter = Reformatter{indent};
+
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        auto size = static_cast<size_t>(in.gcount());
+        if (!size) {
+            break;
+        }
+        result.clear();
+        formatter.feed({buffer.data(), size}, result);
+        out.write(result.data(), static_cast<std::streamsize>(result.size()));
+    }
+    formatter.finish();
+}
+
+inline std::string reformat(std::string_view input, int indent) {
+    auto result = std::string{};
+    result.reserve(indent < 0 ? input.size() : input.size() * 2);
+    auto formatter = Reformatter{indent};
+    formatter.feed(input, result);
+    formatter.finish();
+    return result;
+}
+
+} // namespace json_internal
+
+/// Remove all whitespace outside of strings. The input is streamed so files
+/// of any size can be used
+inline void minify(std::istream &in, std::ostream &out) {
+    json_internal::reformat(in, out, -1);
+}
+
+inline std::string minify(std::string_view input) {
+    return json_internal::reformat(input, -1);
+}
+
+/// Place every value on its own line, indented with `indent` spaces per level
+inline void prettify(std::istream &in, std::ostream &out, int indent = 2) {
+    json_internal::reformat(in, out, indent < 0 ? 0 : indent);
+}
+
+inline std::string prettify(std::string_view input, int indent = 2) {
+    return json_internal::reformat(input, indent < 0 ? 0 : indent);
+}
+
+} // namespace json
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "jsonnode.h"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace json {
+
+namespace json_internal {
+
+/// Final mixing step from MurmurHash3
+constexpr uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t hash_bytes(std::string_view data, uint64_t seed) {
+    auto h = seed ^ (data.size() * 0x9e3779b97f4a7c15ull);
+    auto p = data.data();
+    auto n = data.size();
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, p, 8);
+        h = mix(h ^ word) + 0x9e3779b97f4a7c15ull;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p, n);
+    return mix(h ^ tail);
+}
+
+/// Seeds that keeps values of different types apart
+enum HashSeed : uint64_t {
+    string_seed = 0x5d1b6a0e3c9f2417ull,
+    number_seed = 0x2b7e151628aed2a6ull,
+    array_seed = 0x9b05688c2b3e6c1full,
+    object_seed = 0x1f83d9abfb41bd6bull,
+    member_seed = 0x5be0cd19137e2179ull,
+};
+
+/// Hash of the unescaped content of a string or key
+inline uint64_t hash_string(std::string_view raw, uint64_t seed = 0) {
+    if (raw.find('\\') == std::string_view::npos) {
+        return hash_bytes(raw, string_seed ^ seed);
+    }
+    return hash_bytes(JsonNode{Token{TokenType::STRING, raw}}.str(),
+                      string_seed ^ seed);
+}
+
+} // namespace json_internal
+
+/// The hash of a object or array in a HashCache, with what the node looked
+/// like when it was hashed
+struct CachedHash {
+    std::string_view source;
+    const JsonNode *children = nullptr;
+    size_t size = 0;
+    uint64_t hash = 0;
+
+    bool is_valid_for(const JsonNode &node) const {
+        auto node_source = node.source();
+        return source.data() == node_source.data() &&
+               source.size() == node_source.size() &&
+               children == node.children() &&
+               size == node.size();
+    }
+};
+
+/// Remembers the hash of each object and array, so that subtrees are only
+/// hashed once. The entries are found by the address of the node and are
+/// only used if the node still has the same source text and children, so
+/// nodes that a Parser reuses for the next document are hashed again.
+///
+/// The text itself is not compared, and a MutableDocument can change a value
+/// without changing the containers above it. Clear the cache if the text of
+/// a cached document is overwritten in place, or after a cached document is
+/// changed by a MutableDocument
+using HashCache = std::unordered_map<const JsonNode *, CachedHash>;
+
+/// A 128 bit hash, for when collisions between many values needs to be ruled
+/// out
+struct Hash128 {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const Hash128 &) const = default;
+};
+
+namespace json_internal {
+
+/// Hash a node where `seed` selects a independent hash function
+inline uint64_t hash_node(const JsonNode &node,
+                          uint64_t seed,
+                          HashCache *cache) {
+    switch (node.value().type) {
+    case TokenType::STRING:
+    case TokenType::KEY:
+        return hash_string(node.value().value, seed);
+    case TokenType::NUMBER:
+        if (auto value = comparable_number(node)) {
+            return mix(std::bit_cast<uint64_t>(*value) ^ number_seed ^ seed);
+        }
+        return hash_string(node.value().value, number_seed ^ seed);
+    case TokenType::BOOLEAN:
+        return mix((node.boolean() ? 0x6a09e667f3bcc908ull
+                                   : 0xbb67ae8584caa73bull) ^
+                   seed);
+    case TokenType::NULL_VALUE:
+        return mix(0x3c6ef372fe94f82bull ^ seed);
+    case TokenType::BEGIN_ARRAY:
+    case TokenType::BEGIN_OBJECT: {
+        if (cache) {
+            if (auto it = cache->find(&node);
+                it != cache->end() && it->second.is_valid_for(node)) {
+                return it->second.hash;
+            }
+        }
+        uint64_t h = 0;
+        if (node.value().type == TokenType::BEGIN_ARRAY) {
+            h = array_seed ^ seed;
+            for (auto &child : node) {
+                h = mix(h + hash_node(child, seed, cache));
+            }
+        }
+        else {
+            // Addition is used since the order of the members does not
+            // matter
+            h = object_seed ^ seed;
+            for (auto &key : node) {
+                h += mix(hash_string(key.value().value, seed) ^
+                         (hash_node(*key.children(), seed, cache) +
+                          member_seed));
+            }
+            h = mix(h);
+        }
+        h = mix(h ^ node.size());
+        if (cache) {
+            (*cache)[&node] = {node.source(),
+                               node.children(),
+                               node.size(),
+                               h};
+        }
+        return h;
+    }
+    default:
+        return 0;
+    }
+}
+
+} // namespace json_internal
+
+/// A 64 bit hash of a value where values that are equal (see
+/// json_internal::equal()) gets the same hash: strings are hashed after
+/// escapes are applied, numbers by their value and objects without regard to
+/// the order of the keys. Values with the same canonical form
+/// (see canonical.h) therefore have the same hash.
+///
+/// If `cache` is set, the hash of every container in the subtree is stored
+/// there and reused the next time
+inline uint64_t structural_hash(const JsonNode &node,
+                                HashCache *cache = nullptr) {
+    return json_internal::hash_node(node, 0, cache);
+}
+
+/// The same as structural_hash() but with 128 bits. The low part is the same
+/// as the 64 bit hash. Each half can have its own cache
+inline Hash128 structural_hash128(const JsonNode &node,
+                                  HashCache *cache_low = nullptr,
+                                  HashCache *cache_high = nullptr) {
+    return {json_internal::hash_node(node, 0, cache_low),
+            json_internal::hash_node(node, 0x243f6a8885a308d3ull, cache_high)};
+}
+
+} // namespace json
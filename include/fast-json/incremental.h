@@ -0,0 +1,277 @@
+#pragma once
+
+#include "json.h"
+#include <algorithm>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+/// A parsed document that is kept up to date while its text is edited, for
+/// example in a editor. apply_edit() changes the text and parses only the
+/// smallest object or array that contains the change. The new nodes are
+/// placed where the old container was, and the rest of the tree is kept; the
+/// nodes after the change are moved to the new positions in the text, which
+/// does not require any tokenizing.
+///
+/// The nodes refer to the text of the document, so nodes obtained before an
+/// edit are not valid after it
+class IncrementalDocument {
+public:
+    explicit IncrementalDocument(std::string text,
+                                 const ParseOptions &options = {})
+        : _text{std::move(text)}
+        , _options{options} {
+        reparse_all();
+    }
+
+    IncrementalDocument(const IncrementalDocument &) = delete;
+    IncrementalDocument &operator=(const IncrementalDocument &) = delete;
+
+    /// Throws if the last edit left the text invalid
+    const JsonNode &root() const {
+        if (!_root) {
+            throw std::runtime_error{"document contains a parse error"};
+        }
+        return *_root;
+    }
+
+    const JsonNode *operator->() const {
+        return &root();
+    }
+
+    const JsonNode &operator*() const {
+        return root();
+    }
+
+    const JsonNode &operator[](std::string_view name) const {
+        return root().at(name);
+    }
+
+    std::string_view text() const {
+        return _text;
+    }
+
+    /// False if the last edit made the text invalid json. The next edit
+    /// parses the whole text again
+    bool is_valid() const {
+        return _root;
+    }
+
+    /// The position of a node in the text, see JsonNode::source()
+    size_t offset(const JsonNode &node) const {
+        return static_cast<size_t>(node.source().data() - _text.data());
+    }
+
+    /// Replace `removed` bytes at `offset` with `inserted` and update the
+    /// tree. Returns the node that was parsed again, which is the root if the
+    /// change was not inside of a container. If the new text is invalid the
+    /// ParseError is thrown, the text is kept and is_valid() is false
+    const JsonNode &apply_edit(size_t offset,
+                               size_t removed,
+                               std::string_view inserted) {
+        if (offset > _text.size() || removed > _text.size() - offset) {
+            throw std::out_of_range{"edit is outside of the document"};
+        }
+
+        auto target = _root ? find_container(offset, removed) : nullptr;
+        auto begin = target ? this->offset(*target) : 0;
+        auto end = target ? begin + target->source().size() : 0;
+        auto old_data = _text.data();
+        auto delta = static_cast<std::ptrdiff_t>(inserted.size()) -
+                     static_cast<std::ptrdiff_t>(removed);
+
+        _text.replace(offset, removed, inserted);
+        if (!target) {
+            reparse_all();
+            return *_root;
+        }
+
+        auto edit = Edit{old_data, offset, removed, delta};
+        move_nodes(*_root, target, edit);
+
+        auto size = static_cast<std::ptrdiff_t>(end - begin) + delta;
+        auto source =
+            std::string_view{_text}.substr(begin, static_cast<size_t>(size));
+        auto &nodes = _blocks.emplace_back(&_pool);
+        try {
+            auto num_nodes =
+                json_internal::tokenize(source, _tokens, _options, _stack);
+            json_internal::parse_tokens(
+                source, _tokens, num_nodes, nodes, _stack);
+        }
+        catch (const ParseError &) {
+            // Parse everything so that the error has the position in the
+            // whole text
+            reparse_all();
+            return *_root;
+        }
+        if (nodes.front().source() != source) {
+            // For example brackets that were added in the container
+            reparse_all();
+            return *_root;
+        }
+
+        auto num_replaced = count_nodes(*target);
+        _num_garbage += num_replaced;
+        _num_nodes += nodes.size() - num_replaced;
+        if (target == _root) {
+            _root = target = nodes.data();
+        }
+        else {
+            auto next = target->next();
+            *target = std::move(nodes.front());
+            target->next(next);
+        }
+
+        // Compact when there are more replaced nodes than nodes in the tree
+        if (_num_garbage > _num_nodes) {
+            reparse_all();
+            return *_root;
+        }
+        return *target;
+    }
+
+private:
+    struct Edit {
+        const char *old_data;
+        size_t offset;
+        size_t removed;
+        std::ptrdiff_t delta;
+
+        bool is_moved() const {
+            return delta != 0;
+        }
+    };
+
+    void reparse_all() {
+        _root = nullptr;
+        _blocks.clear();
+        _pool.release();
+        _num_nodes = 0;
+        _num_garbage = 0;
+
+        auto &nodes = _blocks.emplace_back(&_pool);
+        auto num_nodes =
+            json_internal::tokenize(_text, _tokens, _options, _stack);
+        json_internal::parse_tokens(_text, _tokens, num_nodes, nodes, _stack);
+        _root = nodes.data();
+        _num_nodes = nodes.size();
+    }
+
+    /// The innermost object or array where the edit is between the brackets
+    JsonNode *find_container(size_t offset, size_t removed) {
+        auto is_inside = [&](const JsonNode &node) {
+            auto type = node.value().type;
+            if (type != TokenType::BEGIN_OBJECT &&
+                type != TokenType::BEGIN_ARRAY) {
+                return false;
+            }
+            auto begin = this->offset(node);
+            auto end = begin + node.source().size();
+            return offset > begin && offset + removed < end;
+        };
+
+        if (!is_inside(*_root)) {
+            return nullptr;
+        }
+        auto node = _root;
+        while (true) {
+            // The last child that starts before the edit
+            auto children = node->elements();
+            auto it = std::upper_bound(
+                children.begin(),
+                children.end(),
+                offset,
+                [&](size_t pos, const JsonNode &child) {
+                    return pos < this->offset(child);
+                });
+            if (it == children.begin()) {
+                return node;
+            }
+            auto child = &*(it - 1);
+            if (child->value().type == TokenType::KEY) {
+                child = child->children();
+            }
+            if (!child || !is_inside(*child)) {
+                return node;
+            }
+            node = const_cast<JsonNode *>(child);
+        }
+    }
+
+    /// Make the nodes refer to the new text, except `target` that is parsed
+    /// again
+    void move_nodes(JsonNode &root,
+                    const JsonNode *target,
+                    const Edit &edit) {
+        auto new_data = _text.data();
+        auto is_reallocated = new_data != edit.old_data;
+        if (!is_reallocated && !edit.is_moved()) {
+            return;
+        }
+
+        auto map = [&](const char *p) {
+            auto pos = static_cast<size_t>(p - edit.old_data);
+            if (pos >= edit.offset + edit.removed) {
+                pos = static_cast<size_t>(static_cast<std::ptrdiff_t>(pos) +
+                                          edit.delta);
+            }
+            return new_data + pos;
+        };
+
+        auto stack = std::vector<JsonNode *>{&root};
+        while (!stack.empty()) {
+            auto node = stack.back();
+            stack.pop_back();
+            if (node == target) {
+                continue;
+            }
+            // The subtree of a key ends with its value
+            auto last = node->value().type == TokenType::KEY && node->children()
+                            ? node->children()
+                            : node;
+            auto subtree_end = last->source().data() + last->source().size();
+            if (!is_reallocated &&
+                static_cast<size_t>(subtree_end - edit.old_data) <=
+                    edit.offset) {
+                // Before the edit and the text is where it was
+                continue;
+            }
+            auto token = node->value();
+            auto begin = token.value.data();
+            auto end = begin + token.value.size();
+            auto new_begin = map(begin);
+            auto new_end = map(end);
+            token.value = {new_begin, static_cast<size_t>(new_end - new_begin)};
+            node->value(token);
+            for (auto child = node->children(); child; child = child->next()) {
+                stack.push_back(const_cast<JsonNode *>(child));
+            }
+        }
+    }
+
+    static size_t count_nodes(const JsonNode &node) {
+        size_t count = 1;
+        for (auto child = node.children(); child; child = child->next()) {
+            count += count_nodes(*child);
+        }
+        return count;
+    }
+
+    std::string _text;
+    ParseOptions _options;
+    std::pmr::unsynchronized_pool_resource _pool;
+    std::vector<std::pmr::vector<JsonNode>> _blocks;
+    std::pmr::vector<Token> _tokens;
+    json_internal::ParseStack _stack;
+    JsonNode *_root = nullptr;
+    size_t _num_nodes = 0;
+    size_t _num_garbage = 0;
+};
+
+} // namespace json
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "jsonnode.h"
+#include "lineindex.h"
+#include "simd.h"
 #include "token.h"
+#include "utf8.h"
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -11,8 +16,81 @@
 
 namespace json {
 
+/// Settings for parse_json() and Parser
+struct ParseOptions {
+    /// Reject everything that is not valid according to RFC 8259, for example
+    /// trailing commas, invalid numbers, invalid escape sequences and
+    /// content after the root value. The grammar is checked while tokenizing
+    bool strict = false;
+
+    /// Check that all strings are valid UTF-8. Bytes outside of strings are
+    /// always checked since only ascii is allowed there
+    bool validate_utf8 = false;
+
+    /// The maximum nesting of arrays and objects. Deeper input is rejected
+    /// with a ParseError
+    size_t max_depth = 1024;
+};
+
 namespace json_internal {
 
+constexpr bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+/// Check a number against the grammar in RFC 8259
+constexpr bool is_valid_number(std::string_view s) {
+    size_t i = 0;
+    auto n = s.size();
+    if (i < n && s[i] == '-') {
+        ++i;
+    }
+    if (i >= n) {
+        return false;
+    }
+    if (s[i] == '0') {
+        ++i;
+    }
+    else if (is_digit(s[i])) {
+        while (i < n && is_digit(s[i])) {
+            ++i;
+        }
+    }
+    else {
+        return false;
+    }
+    if (i < n && s[i] == '.') {
+        ++i;
+        if (i >= n || !is_digit(s[i])) {
+            return false;
+        }
+        while (i < n && is_digit(s[i])) {
+            ++i;
+        }
+    }
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        ++i;
+        if (i < n && (s[i] == '+' || s[i] == '-')) {
+            ++i;
+        }
+        if (i >= n || !is_digit(s[i])) {
+            return false;
+        }
+        while (i < n && is_digit(s[i])) {
+            ++i;
+        }
+    }
+    return i == n;
+}
+
 class Tokenizer {
 public:
     class const_iterator {
@@ -23,45 +101,64 @@ public:
         using pointer = const Token *;
         using reference = const Token &;
 
-        const_iterator()
+        constexpr const_iterator()
             : _input("")
-            , _pos(0) {}
+            , _pos(0)
+            , _is_done(true) {}
 
-        explicit const_iterator(std::string_view input)
+        constexpr explicit const_iterator(std::string_view input,
+                                const ParseOptions &options = {})
             : _input(input)
-            , _pos(0) {
+            , _pos(0)
+            , _is_strict(options.strict)
+            , _should_validate_utf8(options.validate_utf8) {
             advance();
         }
 
-        reference operator*() const {
+        constexpr reference operator*() const {
             return _current_token;
         }
-        pointer operator->() const {
+        constexpr pointer operator->() const {
             return &_current_token;
         }
 
-        const_iterator &operator++() {
+        constexpr const_iterator &operator++() {
             advance();
             return *this;
         }
 
-        const_iterator operator++(int) {
+        constexpr const_iterator operator++(int) {
             const_iterator tmp(*this);
             operator++();
             return tmp;
         }
 
-        bool operator==(const const_iterator &other) const {
-            return (_input.empty() && other._input.empty()) ||
-                   (_input.data() == other._input.data() && _pos == other._pos);
+        constexpr bool operator==(const const_iterator &other) const {
+            if (_is_done || other._is_done) {
+                return _is_done == other._is_done;
+            }
+            return _input.data() == other._input.data() && _pos == other._pos;
         }
 
-        bool operator!=(const const_iterator &other) const {
+        constexpr bool operator!=(const const_iterator &other) const {
             return !(*this == other);
         }
 
+        /// Throw a ParseError for a position in the input. The line is tracked
+        /// while tokenizing so no rescan is needed
+        [[noreturn]] void throw_error(const std::string &message,
+                                      size_t offset) const {
+            throw ParseError{message, offset, {_line, offset - _line_start + 1}};
+        }
+
+        [[noreturn]] void throw_error(const std::string &message,
+                                      const Token &token) const {
+            throw_error(message + " '" + std::string{token.value} + "'",
+                        static_cast<size_t>(token.value.data() - _input.data()));
+        }
+
     private:
-        void advance() {
+        constexpr void advance() {
             while (_pos < _input.size()) {
                 char c = _input[_pos];
 
@@ -69,73 +166,76 @@ public:
                 case ' ':
                 case '\t':
                 case '\r':
-                case '\n':
                     _pos++; // Ignore whitespace
                     break;
+                case '\n':
+                    new_line(_pos);
+                    _pos++;
+                    break;
                 case '{':
-                    _current_token = {TokenType::BEGIN_OBJECT, "{"};
+                    _current_token = {TokenType::BEGIN_OBJECT,
+                                      _input.substr(_pos, 1)};
                     ++_depth;
                     _pos++;
                     return;
                 case '}':
-                    _current_token = {TokenType::END_OBJECT, "}"};
+                    _current_token = {TokenType::END_OBJECT,
+                                      _input.substr(_pos, 1)};
                     --_depth;
                     _pos++;
                     return;
                 case '[':
-                    _current_token = {TokenType::BEGIN_ARRAY, "["};
+                    _current_token = {TokenType::BEGIN_ARRAY,
+                                      _input.substr(_pos, 1)};
                     _pos++;
                     return;
                 case ']':
-                    _current_token = {TokenType::END_ARRAY, "]"};
+                    _current_token = {TokenType::END_ARRAY,
+                                      _input.substr(_pos, 1)};
                     _pos++;
                     --_depth;
                     return;
                 case ':':
-                    _current_token = {TokenType::COLON, ":"};
+                    _current_token = {TokenType::COLON, _input.substr(_pos, 1)};
                     _pos++;
                     return;
                 case ',':
-                    _current_token = {TokenType::COMMA, ","};
+                    _current_token = {TokenType::COMMA, _input.substr(_pos, 1)};
                     _pos++;
                     return;
                 case '\"': {
                     size_t start = _pos;
                     _pos++; // Move past the opening quote
-                    while (_pos < _input.size() && _input[_pos] != '\"') {
-                        if (_input[_pos] == '\\') {
-                            _pos++; // Skip the escape character
-                        }
-                        _pos++;
-                    }
-                    if (_pos < _input.size() && _input[_pos] == '\"') {
-                        _pos++; // Move past the closing quote
-                        std::string_view value(_input.data() + start,
-                                               _pos - start);
-                        _current_token = {TokenType::STRING,
-                                          value.substr(1, value.size() - 2)};
-                        return;
+                    scan_string();
+                    _pos++; // Move past the closing quote
+                    _current_token = {
+                        TokenType::STRING,
+                        _input.substr(start + 1, _pos - start - 2)};
+                    if (_should_validate_utf8 &&
+                        !is_valid_utf8(_current_token.value)) {
+                        throw_error("Invalid UTF-8 in string", start);
                     }
-                    else {
-                        throw std::runtime_error("Unterminated string");
-                    }
-                    break;
+                    return;
                 }
                 default: {
-                    if (isdigit(c) || c == '-' || c == '+') {
+                    if (is_digit(c) || c == '-' || c == '+') {
                         size_t start = _pos;
                         while (_pos < _input.size() &&
-                               (isdigit(_input[_pos]) || _input[_pos] == '.')) {
+                               is_number_character(_input[_pos])) {
                             _pos++;
                         }
                         std::string_view value(_input.data() + start,
                                                _pos - start);
+                        if (_is_strict && !is_valid_number(value)) {
+                            throw_error("Invalid number " + std::string{value},
+                                        start);
+                        }
                         _current_token = {TokenType::NUMBER, value};
                         return;
                     }
-                    else if (isalpha(c)) {
+                    else if (is_alpha(c)) {
                         size_t start = _pos;
-                        while (_pos < _input.size() && isalpha(_input[_pos])) {
+                        while (_pos < _input.size() && is_alpha(_input[_pos])) {
                             _pos++;
                         }
                         std::string_view value(_input.data() + start,
@@ -149,118 +249,526 @@ public:
                             return;
                         }
                         else {
-                            throw std::runtime_error("Unexpected value " +
-                                                     std::string{value});
+                            throw_error("Unexpected value " +
+                                            std::string{value},
+                                        start);
                         }
                     }
                     else {
-                        throw std::runtime_error("Unexpected character");
+                        throw_error("Unexpected character", _pos);
                     }
                 }
                 }
             }
 
-            *this = const_iterator{};
+            _current_token = {};
+            _is_done = true;
+        }
+
+        constexpr void new_line(size_t pos) {
+            ++_line;
+            _line_start = pos + 1;
+        }
+
+        static constexpr bool is_number_character(char c) {
+            return is_digit(c) || c == '.' || c == 'e' || c == 'E' ||
+                   c == '+' || c == '-';
+        }
+
+        /// Move to the closing quote of the current string
+        constexpr void scan_string() {
+            auto data = _input.data();
+            auto end = data + _input.size();
+            auto start = _pos - 1;
+            while (true) {
+                auto p =
+                    _is_strict ? find_string_special(data + _pos, end)
+                               : find_any<'\"', '\\', '\n'>(data + _pos, end);
+                _pos = static_cast<size_t>(p - data);
+                if (_pos >= _input.size()) {
+                    throw_error("Unterminated string", start);
+                }
+                switch (*p) {
+                case '\"':
+                    return;
+                case '\\':
+                    if (_pos + 1 >= _input.size()) {
+                        throw_error("Unterminated string", start);
+                    }
+                    if (_is_strict) {
+                        validate_escape();
+                    }
+                    _pos += 2; // Skip the escape character
+                    break;
+                case '\n':
+                    if (!_is_strict) {
+                        // Allowed in lenient mode but keep track of lines
+                        new_line(_pos);
+                        ++_pos;
+                        break;
+                    }
+                    [[fallthrough]];
+                default:
+                    throw_error("Unescaped control character in string",
+                                _pos);
+                }
+            }
+        }
+
+        /// Check the escape sequence starting at _pos
+        constexpr void validate_escape() const {
+            if (_pos + 1 >= _input.size()) {
+                throw_error("Unterminated string", _pos);
+            }
+            switch (_input[_pos + 1]) {
+            case '\"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                return;
+            case 'u':
+                if (_pos + 5 < _input.size() && is_hex(_input[_pos + 2]) &&
+                    is_hex(_input[_pos + 3]) && is_hex(_input[_pos + 4]) &&
+                    is_hex(_input[_pos + 5])) {
+                    return;
+                }
+                break;
+            default:
+                break;
+            }
+            throw_error("Invalid escape sequence in string", _pos);
         }
 
         std::string_view _input;
         size_t _pos;
         Token _current_token;
         int _depth = 0;
+        size_t _line = 1;
+        size_t _line_start = 0;
+        bool _is_strict = false;
+        bool _should_validate_utf8 = false;
+        bool _is_done = false;
     };
 
-    explicit Tokenizer(std::string_view input)
-        : _input(input) {}
+    constexpr explicit Tokenizer(std::string_view input,
+                                 const ParseOptions &options = {})
+        : _input(input)
+        , _options(options) {}
 
-    const_iterator begin() const {
-        return const_iterator(_input);
+    constexpr const_iterator begin() const {
+        return const_iterator(_input, _options);
     }
 
-    static const_iterator end() {
+    static constexpr const_iterator end() {
         return const_iterator();
     }
 
 private:
     std::string_view _input;
+    ParseOptions _options;
 };
 
-inline JsonNode *parse_recursive(Tokenizer::const_iterator &it,
-                                 std::vector<JsonNode> &nodes,
-                                 int &current_index) {
-    auto &token = *it;
-    auto &current_node = nodes.at(current_index);
-
-    switch (token.type) {
-    case TokenType::BEGIN_OBJECT:
-    case TokenType::BEGIN_ARRAY: {
-        //        ++current_index;
-        current_node = JsonNode{token};
+/// Checks the grammar of a stream of tokens with a stack of the open
+/// containers. Used by the strict mode. Errors are returned as messages so
+/// that the tokenizer can report them with the position of the token.
+///
+/// `String` holds the kinds of the open containers, a std::pmr::string lets
+/// tokenize() keep it with the other scratch memory of the parser
+template <typename String = std::string>
+class GrammarValidator {
+public:
+    constexpr GrammarValidator() = default;
 
-        JsonNode *previous = nullptr;
+    constexpr explicit GrammarValidator(String stack)
+        : _stack{std::move(stack)} {}
 
-        ++it;
+    /// Start over with a new document, keeping the memory of the stack
+    constexpr void reset() {
+        _stack.clear();
+        _expect = Expect::Value;
+    }
 
-        for (; it != Tokenizer::const_iterator{}; ++it) {
-            if (it->type == TokenType::END_OBJECT ||
-                it->type == TokenType::END_ARRAY) {
-                return &current_node;
+    /// Returns a error message or null if the token is valid
+    constexpr const char *feed(const Token &token) {
+        switch (token.type) {
+        case TokenType::BEGIN_OBJECT:
+        case TokenType::BEGIN_ARRAY:
+            if (auto error = expect_value()) {
+                return error;
             }
-
-            ++current_index;
-            if (it->type == TokenType::COLON) {
-                if (!previous) {
-                    throw std::runtime_error{"unexpected colon"};
-                }
-                previous->value(Token{TokenType::KEY, previous->value().value});
-                ++it;
-                auto value = parse_recursive(it, nodes, current_index);
-                previous->children(value);
+            if (token.type == TokenType::BEGIN_OBJECT) {
+                _stack.push_back('{');
+                _expect = Expect::FirstKey;
             }
             else {
-                auto new_node = parse_recursive(it, nodes, current_index);
-                if (!new_node) {
-                    continue;
-                }
-                if (previous) {
-                    previous->next(new_node);
-                }
-                else {
-                    current_node.children(new_node);
-                }
-                previous = new_node;
+                _stack.push_back('[');
+                _expect = Expect::FirstValue;
+            }
+            return nullptr;
+        case TokenType::END_OBJECT:
+        case TokenType::END_ARRAY: {
+            bool is_object = token.type == TokenType::END_OBJECT;
+            if (_stack.empty() || (_stack.back() == '{') != is_object) {
+                return "Mismatched bracket";
             }
+            if (_expect != Expect::CommaOrEnd &&
+                _expect != (is_object ? Expect::FirstKey
+                                      : Expect::FirstValue)) {
+                return "Unexpected";
+            }
+            _stack.pop_back();
+            after_value();
+            return nullptr;
+        }
+        case TokenType::COLON:
+            if (_expect != Expect::Colon) {
+                return "Unexpected";
+            }
+            _expect = Expect::Value;
+            return nullptr;
+        case TokenType::COMMA:
+            if (_expect != Expect::CommaOrEnd) {
+                return "Unexpected";
+            }
+            _expect = _stack.back() == '{' ? Expect::Key : Expect::Value;
+            return nullptr;
+        case TokenType::STRING:
+            if (_expect == Expect::Key || _expect == Expect::FirstKey) {
+                _expect = Expect::Colon;
+                return nullptr;
+            }
+            [[fallthrough]];
+        default:
+            if (auto error = expect_value()) {
+                return error;
+            }
+            after_value();
+            return nullptr;
         }
-        return &current_node;
-        break;
     }
-    case TokenType::END_ARRAY:
-    case TokenType::END_OBJECT:
-    case TokenType::COLON:
-    case TokenType::KEY:
-    case TokenType::INVALID:
-        throw std::runtime_error{"unexpected character " +
-                                 std::string{token.value}};
-        break;
-    case TokenType::STRING:
-    case TokenType::NUMBER:
-    case TokenType::BOOLEAN:
-    case TokenType::NULL_VALUE: {
-        current_node = JsonNode{token};
-        return &current_node;
-        break;
+
+    /// Check that the root value is complete
+    constexpr const char *finish() const {
+        if (_expect != Expect::Done) {
+            return "Unexpected end of input";
+        }
+        return nullptr;
     }
-    case TokenType::COMMA:
+
+private:
+    enum class Expect : char {
+        Value,
+        FirstValue, // A value or end of array
+        Key,
+        FirstKey, // A key or end of object
+        Colon,
+        CommaOrEnd,
+        Done,
+    };
+
+    constexpr const char *expect_value() const {
+        if (_expect == Expect::Done) {
+            return "Unexpected content after root value";
+        }
+        if (_expect != Expect::Value && _expect != Expect::FirstValue) {
+            return "Unexpected";
+        }
         return nullptr;
-        break;
     }
 
-    return nullptr;
+    constexpr void after_value() {
+        _expect = _stack.empty() ? Expect::Done : Expect::CommaOrEnd;
+    }
+
+    String _stack;
+    Expect _expect = Expect::Value;
 };
+
+/// Throw a ParseError for a token that is found after tokenizing, when the
+/// line is not known. Only used for errors so the text is rescanned here
+[[noreturn]] inline void throw_parse_error(const std::string &message,
+                                           std::string_view input,
+                                           const Token &token) {
+    auto index = LineIndex{input};
+    auto offset = index.offset(token);
+    throw ParseError{message + " '" + std::string{token.value} + "'",
+                     offset,
+                     index.location(offset)};
+}
+
+/// An open object or array while building the tree
+struct ParseFrame {
+    JsonNode *container = nullptr;
+
+    /// The slots of the children, in order
+    JsonNode *children = nullptr;
+
+    /// Number of children placed so far
+    size_t size = 0;
+};
+
+/// Scratch memory for tokenize() and parse_tokens(), kept by Parser between
+/// documents
+struct ParseStack {
+    explicit ParseStack(
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : frames{resource}
+        , sizes{resource}
+        , open{resource}
+        , validator{std::pmr::string{resource}} {}
+
+    std::pmr::vector<ParseFrame> frames;
+
+    /// Number of children of each object and array, in the order they begin
+    std::pmr::vector<size_t> sizes;
+
+    /// Positions in `sizes` of the open containers while tokenizing
+    std::pmr::vector<size_t> open;
+
+    /// Used by tokenize() in strict mode
+    GrammarValidator<std::pmr::string> validator;
+};
+
+/// Tokenize the whole input into `tokens` (the structural index of the
+/// document), and count the children of each object and array into
+/// `stack.sizes` in the order they begin, with the same rules as
+/// parse_iterative() uses to place them. Returns the number of nodes needed
+/// to parse the tokens. Fails at the first container deeper than
+/// `options.max_depth`
+inline size_t tokenize(std::string_view input,
+                       std::pmr::vector<Token> &tokens,
+                       const ParseOptions &options,
+                       ParseStack &stack) {
+    tokens.clear();
+    auto &sizes = stack.sizes;
+    auto &open = stack.open;
+    sizes.clear();
+    open.clear();
+    size_t num_nodes = 0;
+    auto is_value = false; // The next value belongs to a key
+
+    auto &validator = stack.validator;
+    validator.reset();
+    auto tokenizer = Tokenizer{input, options};
+    auto it = tokenizer.begin();
+    for (; it != tokenizer.end(); ++it) {
+        auto &token = *it;
+        switch (token.type) {
+        case TokenType::BEGIN_OBJECT:
+        case TokenType::BEGIN_ARRAY:
+            if (open.size() >= options.max_depth) {
+                it.throw_error("maximum depth " +
+                                   std::to_string(options.max_depth) +
+                                   " exceeded by",
+                               token);
+            }
+            ++num_nodes;
+            if (!open.empty() && !is_value) {
+                ++sizes[open.back()];
+            }
+            is_value = false;
+            open.push_back(sizes.size());
+            sizes.push_back(0);
+            break;
+        case TokenType::END_ARRAY:
+        case TokenType::END_OBJECT:
+            if (!open.empty()) {
+                open.pop_back();
+            }
+            is_value = false;
+            break;
+        case TokenType::COLON:
+            is_value = true;
+            break;
+        case TokenType::STRING:
+        case TokenType::NUMBER:
+        case TokenType::BOOLEAN:
+        case TokenType::NULL_VALUE:
+            ++num_nodes;
+            if (!open.empty() && !is_value) {
+                ++sizes[open.back()];
+            }
+            is_value = false;
+            break;
+        default:
+            is_value = false;
+            break;
+        }
+        if (options.strict) {
+            if (auto error = validator.feed(token)) {
+                it.throw_error(error, token);
+            }
+        }
+        tokens.push_back(token);
+    }
+    if (options.strict) {
+        if (auto error = validator.finish()) {
+            it.throw_error(error, input.size());
+        }
+    }
+    return num_nodes;
+}
+
+/// Build the node tree from the tokens without recursion, the open containers
+/// are kept in `stack`. The depth is already limited by tokenize().
+///
+/// The children of each container are placed after each other in `nodes`, so
+/// that JsonNode::size() and indexing is constant time. The children are
+/// counted by tokenize(), so each container reserves the slots for its
+/// children when it begins and every node is written once. The root is
+/// placed first
+inline void parse_iterative(std::string_view input,
+                            const Token *it,
+                            const Token *end,
+                            JsonNode *nodes,
+                            ParseStack &stack) {
+    auto &frames = stack.frames;
+    frames.clear();
+
+    auto out = nodes + 1;    // Next free slot, the first is for the root
+    auto size = stack.sizes.data(); // Of the next container
+    JsonNode *key = nullptr; // Set when the next value belongs to a key
+    auto current = ParseFrame{};
+
+    // The slot of the next value: after the pending key, in the current
+    // container, or the root
+    auto slot = [&]() -> JsonNode & {
+        if (key) {
+            auto node = out++;
+            key->children(node);
+            key = nullptr;
+            return *node;
+        }
+        if (!current.container) {
+            return *nodes;
+        }
+        auto node = current.children + current.size;
+        if (current.size++) {
+            (node - 1)->next(node);
+        }
+        return *node;
+    };
+
+    auto close = [&](const Token *end_token) {
+        auto &container = *current.container;
+        container.children(current.size ? current.children : nullptr,
+                           current.size);
+        if (end_token) {
+            // Let the container refer to all of its source text
+            auto begin = container.value().value.data();
+            container.value(Token{
+                container.value().type,
+                std::string_view{
+                    begin,
+                    static_cast<size_t>(end_token->value.data() + 1 - begin)}});
+        }
+        current = frames.back();
+        frames.pop_back();
+    };
+
+    for (; it != end; ++it) {
+        auto &token = *it;
+
+        switch (token.type) {
+        case TokenType::BEGIN_OBJECT:
+        case TokenType::BEGIN_ARRAY: {
+            auto &node = slot();
+            node = JsonNode{token};
+            frames.push_back(current);
+            current = {&node, out, 0};
+            out += *size++;
+            break;
+        }
+        case TokenType::END_ARRAY:
+        case TokenType::END_OBJECT:
+            if (key || !current.container) {
+                throw_parse_error("unexpected character", input, token);
+            }
+            close(&token);
+            if (!current.container) {
+                return; // End of the root value
+            }
+            break;
+        case TokenType::COLON:
+            if (key) {
+                throw_parse_error("unexpected character", input, token);
+            }
+            if (!current.size) {
+                throw_parse_error("unexpected colon", input, token);
+            }
+            if (it + 1 == end) {
+                throw_parse_error("expected value after", input, token);
+            }
+            key = current.children + current.size - 1;
+            key->value(Token{TokenType::KEY, key->value().value});
+            break;
+        case TokenType::COMMA:
+            if (!current.container) {
+                return;
+            }
+            key = nullptr; // A key without value
+            break;
+        case TokenType::STRING:
+        case TokenType::NUMBER:
+        case TokenType::BOOLEAN:
+        case TokenType::NULL_VALUE:
+            slot() = JsonNode{token};
+            if (!current.container) {
+                return; // The root is a single value
+            }
+            break;
+        case TokenType::KEY:
+        case TokenType::INVALID:
+            throw_parse_error("unexpected character", input, token);
+        }
+    }
+
+    // Unterminated containers in lenient mode keep what was found
+    while (current.container) {
+        close(nullptr);
+    }
+}
+
+/// Parse already tokenized input into `nodes`. `stack` needs to be the one
+/// that was passed to tokenize() for `tokens`. The capacity of `nodes` and
+/// `stack` is reused if it is large enough
+inline void parse_tokens(std::string_view input,
+                         const std::pmr::vector<Token> &tokens,
+                         size_t num_nodes,
+                         std::pmr::vector<JsonNode> &nodes,
+                         ParseStack &stack) {
+    if (tokens.empty()) {
+        throw ParseError{"no json value found in input", 0, {1, 1}};
+    }
+    // Every node in the tree is written by parse_iterative(), so the nodes of
+    // a previous document are kept without clearing them, apart from the root
+    // that is not written for input without a value
+    nodes.resize(std::max(num_nodes, size_t{1}));
+    nodes.front() = JsonNode{};
+
+    parse_iterative(input,
+                    tokens.data(),
+                    tokens.data() + tokens.size(),
+                    nodes.data(),
+                    stack);
+
+#ifdef FAST_JSON_PROFILE_ACCESS
+    // While the keys in the text are still alive
+    AccessProfiler::global().add_document(nodes.front());
+#endif
+}
+
 } // namespace json_internal
 
 /// A container for the result
+/// The nodes are allocated from the memory resource passed to parse_json(), so
+/// a whole document can be placed in a arena that is released at once
 struct JsonRoot {
-    std::vector<JsonNode> nodes;
+    std::pmr::vector<JsonNode> nodes;
 
     const JsonNode *operator->() const {
         return &nodes.front();
@@ -275,30 +783,112 @@ struct JsonRoot {
     }
 };
 
-inline JsonRoot parse_json(std::string_view input) {
+/// Parse a json string. Note that the result refers to the input string, so the
+/// input need to be kept alive as long as the result is used.
+/// All nodes is allocated with `resource`
+inline JsonRoot parse_json(
+    std::string_view input,
+    const ParseOptions &options,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
     using namespace json_internal;
-    size_t num_nodes = 0;
 
-    // First pass: Count the number of JSON nodes
-    for (auto &token : Tokenizer{input}) {
-        if (token.type == TokenType::BEGIN_OBJECT ||
-            token.type == TokenType::BEGIN_ARRAY ||
-            token.type == TokenType::STRING ||
-            token.type == TokenType::NUMBER ||
-            token.type == TokenType::BOOLEAN ||
-            token.type == TokenType::COLON ||
-            token.type == TokenType::NULL_VALUE) {
-            ++num_nodes;
+    auto tokens = std::pmr::vector<Token>{resource};
+    auto stack = ParseStack{resource};
+    auto num_nodes = tokenize(input, tokens, options, stack);
+
+    auto root = JsonRoot{std::pmr::vector<JsonNode>{resource}};
+    parse_tokens(input, tokens, num_nodes, root.nodes, stack);
+
+    return root;
+}
+
+inline JsonRoot parse_json(
+    std::string_view input,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+    return parse_json(input, ParseOptions{}, resource);
+}
+
+/// Check that the input is valid json according to RFC 8259 (including UTF-8
+/// encoding) without creating any nodes. Throws std::runtime_error if the input
+/// is invalid
+inline void validate_json(std::string_view input) {
+    using namespace json_internal;
+    auto validator = GrammarValidator{};
+    auto tokenizer =
+        Tokenizer{input, ParseOptions{.strict = true, .validate_utf8 = true}};
+    auto it = tokenizer.begin();
+    for (; it != tokenizer.end(); ++it) {
+        if (auto error = validator.feed(*it)) {
+            it.throw_error(error, *it);
         }
     }
+    if (auto error = validator.finish()) {
+        it.throw_error(error, input.size());
+    }
+}
+
+/// Same as validate_json() but returns false instead of throwing
+inline bool is_valid_json(std::string_view input) {
+    try {
+        validate_json(input);
+        return true;
+    }
+    catch (std::runtime_error &) {
+        return false;
+    }
+}
+
+/// A parser that keeps its buffers between documents. When used for many
+/// documents in a row, the parser stops allocating memory when the buffers
+/// has grown large enough for the largest document.
+///
+/// The result of parse() is valid until the next call to parse() (and as long
+/// as the input string is kept alive)
+class Parser {
+public:
+    explicit Parser(
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : Parser{ParseOptions{}, resource} {}
+
+    explicit Parser(
+        const ParseOptions &options,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : _options{options}
+        , _tokens{resource}
+        , _root{std::pmr::vector<JsonNode>{resource}}
+        , _stack{resource}
+        , _scratch{resource} {}
+
+    Parser(const Parser &) = delete;
+    Parser &operator=(const Parser &) = delete;
+
+    const JsonRoot &parse(std::string_view input) {
+        using namespace json_internal;
+        auto num_nodes = tokenize(input, _tokens, _options, _stack);
+        parse_tokens(input, _tokens, num_nodes, _root.nodes, _stack);
+        return _root;
+    }
 
-    std::vector<JsonNode> nodes(num_nodes);
-    int current_index = 0;
+    /// Unescape a string value into the parsers scratch buffer. The result is
+    /// valid until the next call to str() or parse()
+    std::string_view str(const JsonNode &node) {
+        _scratch.clear();
+        node.unescape_to(_scratch);
+        return _scratch;
+    }
 
-    auto it = Tokenizer{input}.begin();
-    parse_recursive(it, nodes, current_index);
+    /// Prepare the buffers for documents of the specified size
+    void reserve(size_t num_tokens) {
+        _tokens.reserve(num_tokens);
+        _root.nodes.reserve(num_tokens);
+    }
 
-    return {std::move(nodes)};
-}
+private:
+    ParseOptions _options;
+    std::pmr::vector<Token> _tokens;
+    JsonRoot _root;
+    json_internal::ParseStack _stack;
+    std::pmr::string _scratch;
+};
 
 } // namespace json
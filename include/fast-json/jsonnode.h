@@ -1,8 +1,14 @@
 #pragma once
 
 #include "token.h"
+#include <atomic>
 #include <charconv>
+#include <concepts>
+#include <cstdint>
 #include <iomanip>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -14,6 +20,33 @@ concept HasFromJsonFunction = requires(T &obj, const class JsonNode &json) {
     { obj.from_json(json) };
 };
 
+/// Strings that can be filled with unescaped content, with any allocator
+template <typename T>
+concept JsonString = requires(T &str) {
+    typename T::traits_type;
+    requires std::same_as<typename T::value_type, char>;
+    str.push_back('a');
+    str.clear();
+};
+
+/// Sequence containers (like std::vector or std::pmr::vector) that can be
+/// deserialized from a json array. Elements are constructed with the
+/// containers own allocator
+template <typename T>
+concept JsonSequence = !JsonString<T> && requires(T &container) {
+    typename T::value_type;
+    container.emplace_back();
+    container.back();
+    container.clear();
+};
+
+#ifdef FAST_JSON_PROFILE_ACCESS
+namespace json_internal {
+// Defined in profile.h
+void record_profiled_access(uint32_t id, bool is_first, size_t size);
+} // namespace json_internal
+#endif
+
 /// Object containing parsed json information. Note that you need to use
 /// json::parse_json() to get one of those objects
 class JsonNode {
@@ -82,6 +115,17 @@ public:
         return _value = value;
     }
 
+    /// The text in the input that the value was parsed from. For strings and
+    /// keys the quotes are included and for objects and arrays the whole
+    /// content including the brackets
+    std::string_view source() const {
+        auto &text = _value.value;
+        if (_value.type == TokenType::STRING || _value.type == TokenType::KEY) {
+            return {text.data() - 1, text.size() + 2};
+        }
+        return text;
+    }
+
     /// The first child
     const JsonNode &front() const {
         if (!_children) {
@@ -92,6 +136,11 @@ public:
 
     const_iterator begin() const {
         if (!_children) {
+            // Empty objects and arrays just have no children
+            if (_value.type == TokenType::BEGIN_OBJECT ||
+                _value.type == TokenType::BEGIN_ARRAY) {
+                return end();
+            }
             throw std::out_of_range{"no children in node"};
         }
         return const_iterator(children());
@@ -111,6 +160,28 @@ public:
         _children = children;
     }
 
+    /// Set the children of a object or array. The children needs to be placed
+    /// after each other in memory
+    void children(const JsonNode *children, size_t size) {
+        _children = children;
+        _size = static_cast<uint32_t>(size);
+    }
+
+    /// Number of elements in a array or members in a object
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return !_size;
+    }
+
+    /// The children as a contiguous range. The iterators are random access
+    /// so the range can be used with for example parallel algorithms
+    std::span<const JsonNode> elements() const {
+        return {_children, _size};
+    }
+
     const JsonNode *next() const {
         return _next;
     }
@@ -129,6 +200,7 @@ public:
             child.validate_key();
             if (child.value().value == name) {
                 // Note that a key actually holds it's value as a child
+                child.children()->record_access();
                 return *child.children();
             }
         }
@@ -141,6 +213,21 @@ public:
         return at(name);
     }
 
+    /// Get array element by index. Does not need to walk the array
+    const JsonNode &at(size_t index) const {
+        validate_array();
+        if (index >= _size) {
+            throw std::out_of_range{"index " + std::to_string(index) +
+                                    " out of range"};
+        }
+        _children[index].record_access();
+        return _children[index];
+    }
+
+    const JsonNode &operator[](size_t index) const {
+        return at(index);
+    }
+
     /// Try to find a element by name, but return null if no child was found
     const JsonNode *find(std::string_view name) const {
         if (_value.type == TokenType::KEY) {
@@ -150,6 +237,7 @@ public:
         for (auto it = begin(); it != end(); ++it) {
             it->validate_key();
             if (it->value().value == name) {
+                it->children()->record_access();
                 return it->children();
             }
         }
@@ -162,6 +250,7 @@ public:
     template <typename F>
     void visit(F f) const {
         validate_object();
+        record_access();
 
         for (auto &key : *this) {
             auto &child = *key.children();
@@ -175,6 +264,7 @@ public:
     template <typename T = int>
     T number() const {
         validate_number();
+        record_access();
         auto out = T{};
         const std::from_chars_result result =
             std::from_chars(_value.value.data(),
@@ -189,6 +279,7 @@ public:
 
     bool boolean() const {
         validate_bool();
+        record_access();
         return _value.value == "true";
     }
 
@@ -196,66 +287,81 @@ public:
     /// generate the json object
     std::string_view raw() const {
         validate_string();
+        record_access();
         return _value.value;
     }
 
     /// Get a string where the escape characters is applied
     std::string str() const {
         auto res = std::string{};
+        unescape_to(res);
+        return res;
+    }
 
-        bool escaped = false;
-        for (auto c :
-             raw()) { // assuming str() returns the original escaped string
-            if (escaped) {
-                char e = 0;
-                switch (c) {
-                case '\"':
-                    e = '\"';
-                    break; // Quotation mark
-                case '\\':
-                    e = '\\';
-                    break; // Reverse solidus
-                case '/':
-                    e = '/';
-                    break; // Solidus
-                case 'b':
-                    e = '\b';
-                    break; // Backspace
-                case 'f':
-                    e = '\f';
-                    break; // Form feed
-                case 'n':
-                    e = '\n';
-                    break; // Newline
-                case 'r':
-                    e = '\r';
-                    break; // Carriage return
-                case 't':
-                    e = '\t';
-                    break; // Horizontal tab
-                // add more case labels here if needed
-                default:
-                    // Handle error: invalid escape sequence.
-                    throw std::runtime_error("Invalid escape sequence: \\" +
-                                             std::string(1, c));
-                }
-                res.push_back(e);
-                escaped = false;
-            }
-            else if (c == '\\') {
-                escaped = true;
-            }
-            else {
+    /// Same as str() but the memory is taken from the specified memory
+    /// resource, for example a std::pmr::monotonic_buffer_resource
+    std::pmr::string str(std::pmr::memory_resource *resource) const {
+        auto res = std::pmr::string{resource};
+        unescape_to(res);
+        return res;
+    }
+
+    /// Append the string with escape characters applied to `res`. Unicode
+    /// escapes (\uXXXX) are converted to UTF-8
+    template <JsonString String>
+    void unescape_to(String &res) const {
+        auto raw_value = raw();
+        res.reserve(res.size() + raw_value.size());
+
+        for (size_t i = 0; i < raw_value.size(); ++i) {
+            auto c = raw_value[i];
+            if (c != '\\') {
                 res.push_back(c);
+                continue;
             }
-        }
 
-        // Check if string ends with a single backslash
-        if (escaped) {
-            throw std::runtime_error("String ends with an unescaped backslash");
-        }
+            if (++i >= raw_value.size()) {
+                throw std::runtime_error(
+                    "String ends with an unescaped backslash");
+            }
 
-        return res;
+            c = raw_value[i];
+            char e = 0;
+            switch (c) {
+            case '\"':
+                e = '\"';
+                break; // Quotation mark
+            case '\\':
+                e = '\\';
+                break; // Reverse solidus
+            case '/':
+                e = '/';
+                break; // Solidus
+            case 'b':
+                e = '\b';
+                break; // Backspace
+            case 'f':
+                e = '\f';
+                break; // Form feed
+            case 'n':
+                e = '\n';
+                break; // Newline
+            case 'r':
+                e = '\r';
+                break; // Carriage return
+            case 't':
+                e = '\t';
+                break; // Horizontal tab
+            case 'u':
+                i = unescape_unicode(raw_value, i, res);
+                continue;
+            default:
+                // Handle error: invalid escape sequence.
+                throw std::runtime_error("Invalid escape sequence: \\" +
+                                         std::string(1, c));
+            }
+            res.push_back(e);
+        }
     }
 
     /// Convert the value to a custuom type.
@@ -274,6 +380,14 @@ public:
         return ret;
     }
 
+    template <typename T>
+        requires(JsonSequence<T> && !HasFromJsonFunction<T>)
+    T as() const {
+        auto ret = T{};
+        get_to(ret);
+        return ret;
+    }
+
     /// The same as `as<T>` but places the value on a specified variable
     template <typename T>
     void get_to(T &value) const {
@@ -286,13 +400,117 @@ public:
         value.from_json(*this);
     }
 
+    /// Strings keeps their allocator, so a std::pmr::string stays in its
+    /// memory resource
+    template <JsonString T>
+    void get_to(T &value) const {
+        value.clear();
+        unescape_to(value);
+    }
+
+    /// Fill a container from a json array. The elements is created by the
+    /// container itself so that allocators are propagated to the elements
+    template <JsonSequence T>
+        requires(!HasFromJsonFunction<T>)
+    void get_to(T &value) const {
+        validate_array();
+        value.clear();
+        if constexpr (requires { value.reserve(_size); }) {
+            value.reserve(_size);
+        }
+        for (auto &child : *this) {
+            value.emplace_back();
+            child.get_to(value.back());
+        }
+    }
+
 private:
+    static uint32_t parse_hex4(std::string_view str, size_t pos) {
+        if (pos + 4 > str.size()) {
+            throw std::runtime_error{"Invalid unicode escape sequence"};
+        }
+        uint32_t value = 0;
+        for (size_t i = pos; i < pos + 4; ++i) {
+            auto c = str[i];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<uint32_t>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<uint32_t>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<uint32_t>(c - 'A' + 10);
+            }
+            else {
+                throw std::runtime_error{"Invalid unicode escape sequence"};
+            }
+        }
+        return value;
+    }
+
+    /// Decode a \uXXXX sequence (or a surrogate pair) where `pos` is the
+    /// position of the 'u'. Returns the position of the last character used
+    template <typename String>
+    static size_t unescape_unicode(std::string_view str,
+                                   size_t pos,
+                                   String &res) {
+        auto code_point = parse_hex4(str, pos + 1);
+        pos += 4;
+
+        if (code_point >= 0xdc00 && code_point <= 0xdfff) {
+            throw std::runtime_error{"Unpaired surrogate in unicode escape"};
+        }
+        if (code_point >= 0xd800 && code_point <= 0xdbff) {
+            if (pos + 2 >= str.size() || str[pos + 1] != '\\' ||
+                str[pos + 2] != 'u') {
+                throw std::runtime_error{
+                    "Unpaired surrogate in unicode escape"};
+            }
+            auto low = parse_hex4(str, pos + 3);
+            if (low < 0xdc00 || low > 0xdfff) {
+                throw std::runtime_error{
+                    "Unpaired surrogate in unicode escape"};
+            }
+            code_point = 0x10000 + ((code_point - 0xd800) << 10) +
+                         (low - 0xdc00);
+            pos += 6;
+        }
+
+        if (code_point < 0x80) {
+            res.push_back(static_cast<char>(code_point));
+        }
+        else if (code_point < 0x800) {
+            res.push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+            res.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+        }
+        else if (code_point < 0x10000) {
+            res.push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+            res.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+            res.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+        }
+        else {
+            res.push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+            res.push_back(
+                static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+            res.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+            res.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+        }
+        return pos;
+    }
+
     void validate_object() const {
         if (_value.type != TokenType::BEGIN_OBJECT) {
             throw std::invalid_argument{"json entity is not of type 'object'"};
         }
     }
 
+    void validate_array() const {
+        if (_value.type != TokenType::BEGIN_ARRAY) {
+            throw std::invalid_argument{"json entity is not of type 'array'"};
+        }
+    }
+
     void validate_key() const {
         if (_value.type != TokenType::KEY) {
             throw std::invalid_argument{"json entity is not of type 'key'"};
@@ -320,21 +538,130 @@ private:
         }
     }
 
+    /// Count a read of the value in the AccessProfiler (see profile.h).
+    /// Nothing is done unless FAST_JSON_PROFILE_ACCESS is defined
+    void record_access() const {
+#ifdef FAST_JSON_PROFILE_ACCESS
+        constexpr auto is_read_bit = uint32_t{1} << 31;
+        if (!_profile_id) {
+            return;
+        }
+        auto old = std::atomic_ref{_profile_id}.fetch_or(
+            is_read_bit, std::memory_order_relaxed);
+        json_internal::record_profiled_access(
+            old & ~is_read_bit, !(old & is_read_bit), source().size());
+#endif
+    }
+
     Token _value;
     const JsonNode *_children = nullptr;
     const JsonNode *_next = nullptr;
+    uint32_t _size = 0;
+#ifdef FAST_JSON_PROFILE_ACCESS
+    friend class AccessProfiler;
+
+    // The path of the value in the AccessProfiler, or 0 if it is not
+    // profiled. The highest bit is set when the value has been read. Fits in
+    // the padding, so the size of the node is the same
+    mutable uint32_t _profile_id = 0;
+#endif
 };
 
 template <>
-std::string JsonNode::as<std::string>() const {
+inline std::string JsonNode::as<std::string>() const {
     return str();
 }
 
 template <>
-bool JsonNode::as<bool>() const {
+inline std::pmr::string JsonNode::as<std::pmr::string>() const {
+    return str(std::pmr::get_default_resource());
+}
+
+template <>
+inline bool JsonNode::as<bool>() const {
     return boolean();
 }
 
+namespace json_internal {
+
+/// Escape a string so that it can be placed between quotes in a json document
+template <typename String>
+void escape_to(String &out, std::string_view value) {
+    constexpr auto hex = std::string_view{"0123456789abcdef"};
+    for (char c : value) {
+        switch (c) {
+        case '\"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\b':
+            out += "\\b";
+            break;
+        case '\f':
+            out += "\\f";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out.push_back(hex[(c >> 4) & 0xf]);
+                out.push_back(hex[c & 0xf]);
+            }
+            else {
+                out.push_back(c);
+            }
+        }
+    }
+}
+
+/// The value of a number for comparing it with other numbers, where -0 is 0.
+/// Numbers outside the range of double are not converted and should be
+/// compared by their text instead
+inline std::optional<double> comparable_number(const JsonNode &node) {
+    auto text = node.value().value;
+    auto value = 0.0;
+    auto result =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc{}) {
+        return std::nullopt;
+    }
+    return value == 0 ? 0.0 : value;
+}
+
+/// Escape a key to be used as a reference token in a JSON Pointer
+inline void append_pointer_token(std::string &path, std::string_view raw_key) {
+    auto key = std::string{};
+    auto content = raw_key;
+    if (raw_key.find('\\') != std::string_view::npos) {
+        JsonNode{Token{TokenType::STRING, raw_key}}.unescape_to(key);
+        content = key;
+    }
+    path.push_back('/');
+    for (auto c : content) {
+        if (c == '~') {
+            path += "~0";
+        }
+        else if (c == '/') {
+            path += "~1";
+        }
+        else {
+            path.push_back(c);
+        }
+    }
+}
+
+} // namespace json_internal
+
 /// Print the object to a output stream
 /// Note that the JsonNode is not commonly used for output (since there is the
 /// JsonOut object), but this could be used when you want to view incoming data
@@ -389,7 +716,8 @@ inline void dump(const JsonNode &node, std::ostream &os, int indent = 0) {
         os << std::quoted(node.raw());
         break;
     case TokenType::NUMBER:
-        os << node.number();
+        // Print the number as written to not loose any precision
+        os << node.value().value;
         break;
     case TokenType::BOOLEAN:
         os << std::boolalpha << node.boolean();
@@ -407,3 +735,7 @@ inline std::ostream &operator<<(std::ostream &os, const JsonNode &node) {
     return os;
 }
 } // namespace json
+
+#ifdef FAST_JSON_PROFILE_ACCESS
+#include "profile.h"
+#endif
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <ostream>
+#include <ranges>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -14,6 +15,16 @@ concept HasToJsonFunction = requires(T &obj, struct JsonOut &json) {
     { obj.to_json(json) } -> std::same_as<void>;
 };
 
+/// Anything that can be viewed as a string, including strings with custom
+/// allocators like std::pmr::string
+template <typename T>
+concept IsJsonOutString = std::convertible_to<const T &, std::string_view>;
+
+/// Containers that is printed as json arrays
+template <typename T>
+concept IsJsonOutRange =
+    std::ranges::input_range<const T> && !IsJsonOutString<T>;
+
 /// JsonOut is used to print json objects. It is a simplified implementation
 /// that does not create a real json object, but instead writes to the specified
 /// output stream while pretending to create a object
@@ -79,7 +90,8 @@ public:
     }
 
     template <typename T>
-        requires(!HasToJsonFunction<T>)
+        requires(!HasToJsonFunction<T> && !IsJsonOutString<T> &&
+                 !IsJsonOutRange<T>)
     JsonOut &operator=(const T &value) {
         try_colon();
         *_os << value;
@@ -87,6 +99,29 @@ public:
         return *this;
     }
 
+    template <typename T>
+        requires(!HasToJsonFunction<T> && IsJsonOutString<T>)
+    JsonOut &operator=(const T &value) {
+        return (*this) = std::string_view{value};
+    }
+
+    /// Print a container as a array
+    template <typename T>
+        requires(!HasToJsonFunction<T> && IsJsonOutRange<T>)
+    JsonOut &operator=(const T &values) {
+        bool is_empty = true;
+        for (auto &value : values) {
+            push_back(value);
+            is_empty = false;
+        }
+        if (is_empty) {
+            try_colon();
+            *_os << "[]";
+            set_pending_newline();
+        }
+        return *this;
+    }
+
     template <typename T>
         requires HasToJsonFunction<T>
     JsonOut &operator=(const T &value) {
@@ -226,6 +261,36 @@ public:
         push_back() = value;
     }
 
+    /// Add elements that is already serialized, including the indentation of
+    /// the first element and the separators between them. Used to join
+    /// elements that are serialized separately (see write_array_parallel())
+    void push_back_serialized(std::string_view elements) {
+        print_pending_newline();
+        if (!_is_array) {
+            try_colon();
+            *_os << "[";
+            new_line();
+        }
+        _is_array = true;
+        _has_pending_newline = true;
+        set_pending_newline();
+        _os->write(elements.data(),
+                   static_cast<std::streamsize>(elements.size()));
+    }
+
+    int indent() const {
+        return _indent;
+    }
+
+    int indent_width() const {
+        return _indent_width;
+    }
+
+    /// The stream that is printed to
+    std::ostream &stream() const {
+        return *_os;
+    }
+
 private:
     void try_colon() {
         if (_parent && _parent->_is_object) {
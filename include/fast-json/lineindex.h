@@ -0,0 +1,70 @@
+#pragma once
+
+#include "simd.h"
+#include "token.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/// Maps positions in a document to line and column numbers. The start of each
+/// line is found the first time a location is requested, after that each
+/// lookup is a binary search. Since the index is built on demand, a LineIndex
+/// should not be shared between threads before the first lookup
+class LineIndex {
+public:
+    explicit LineIndex(std::string_view text)
+        : _text{text} {}
+
+    /// Location of a byte offset in the text. Lines and columns start at 1
+    TokenLocation location(size_t offset) const {
+        if (offset > _text.size()) {
+            throw std::out_of_range{"offset outside of text"};
+        }
+        build();
+        auto it =
+            std::upper_bound(_line_starts.begin(), _line_starts.end(), offset);
+        auto line = static_cast<size_t>(it - _line_starts.begin());
+        return {line, offset - *(it - 1) + 1};
+    }
+
+    /// Location of a token that refers to the text
+    TokenLocation location(const Token &token) const {
+        return location(offset(token));
+    }
+
+    /// Byte offset of a token that refers to the text
+    size_t offset(const Token &token) const {
+        auto data = token.value.data();
+        if (data < _text.data() || data > _text.data() + _text.size()) {
+            throw std::out_of_range{"token does not refer to the text"};
+        }
+        return static_cast<size_t>(data - _text.data());
+    }
+
+    size_t num_lines() const {
+        build();
+        return _line_starts.size();
+    }
+
+private:
+    void build() const {
+        if (!_line_starts.empty()) {
+            return;
+        }
+        _line_starts.push_back(0);
+        auto begin = _text.data();
+        auto end = begin + _text.size();
+        for (auto p = begin; (p = json_internal::find_any<'\n'>(p, end)) != end;
+             ++p) {
+            _line_starts.push_back(static_cast<size_t>(p + 1 - begin));
+        }
+    }
+
+    std::string_view _text;
+    mutable std::vector<size_t> _line_starts;
+};
+
+} // namespace json
@@ -0,0 +1,735 @@
+#pragma once
+
+#include "json.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace json {
+
+namespace json_internal {
+
+/// Unescape a reference token of a JSON Pointer (~0 and ~1)
+inline std::string unescape_reference(std::string_view token) {
+    auto res = std::string{};
+    for (size_t i = 0; i < token.size(); ++i) {
+        if (token[i] == '~' && i + 1 < token.size()) {
+            if (token[i + 1] == '0') {
+                res.push_back('~');
+            }
+            else if (token[i + 1] == '1') {
+                res.push_back('/');
+            }
+            else {
+                throw std::invalid_argument{"invalid escape in pointer"};
+            }
+            ++i;
+        }
+        else if (token[i] == '~') {
+            throw std::invalid_argument{"invalid escape in pointer"};
+        }
+        else {
+            res.push_back(token[i]);
+        }
+    }
+    return res;
+}
+
+/// Compare the (raw) content of a key with a unescaped name
+inline bool key_equals(const JsonNode &key, std::string_view name) {
+    auto raw = key.value().value;
+    if (raw.find('\\') == std::string_view::npos) {
+        return raw == name;
+    }
+    return JsonNode{Token{TokenType::STRING, raw}}.str() == name;
+}
+
+/// Compare two json values. Objects are compared without regard to key order,
+/// numbers by their value and strings after escape sequences is applied
+inline bool equal(const JsonNode &a, const JsonNode &b) {
+    auto type = a.value().type;
+    if (type != b.value().type) {
+        return false;
+    }
+
+    switch (type) {
+    case TokenType::STRING:
+        return a.raw() == b.raw() || a.str() == b.str();
+    case TokenType::NUMBER: {
+        if (a.value().value == b.value().value) {
+            return true;
+        }
+        auto value_a = comparable_number(a);
+        auto value_b = comparable_number(b);
+        return value_a && value_b && *value_a == *value_b;
+    }
+    case TokenType::BOOLEAN:
+        return a.boolean() == b.boolean();
+    case TokenType::NULL_VALUE:
+        return true;
+    case TokenType::BEGIN_ARRAY: {
+        auto ia = a.children();
+        auto ib = b.children();
+        for (; ia && ib; ia = ia->next(), ib = ib->next()) {
+            if (!equal(*ia, *ib)) {
+                return false;
+            }
+        }
+        return !ia && !ib;
+    }
+    case TokenType::BEGIN_OBJECT: {
+        size_t num_a = 0;
+        for (auto &key : a) {
+            ++num_a;
+            auto other = b.find(key.value().value);
+            if (!other || !equal(*key.children(), *other)) {
+                return false;
+            }
+        }
+        size_t num_b = 0;
+        for ([[maybe_unused]] auto &key : b) {
+            ++num_b;
+        }
+        return num_a == num_b;
+    }
+    default:
+        return false;
+    }
+}
+
+} // namespace json_internal
+
+/// A document that can be changed after it is parsed. Values and keys can be
+/// added, removed and replaced without reparsing the document, either by
+/// using JSON Pointers (RFC 6901) or by applying a JSON Patch (RFC 6902).
+///
+/// The original input is not copied and needs to be kept alive as long as the
+/// document is used. New values and strings is placed in a arena owned by the
+/// document, so the cost of a edit only depends on the size of the edit and
+/// the width of the containers on the path. The children of a container are
+/// kept after each other with room to grow, so appending is amortized
+/// constant time and inserting or removing moves the children after it.
+class MutableDocument {
+public:
+    explicit MutableDocument(
+        std::string_view input,
+        std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        : _arena{upstream}
+        , _root{parse_value(input)} {}
+
+    MutableDocument(const MutableDocument &) = delete;
+    MutableDocument &operator=(const MutableDocument &) = delete;
+
+    const JsonNode &root() const {
+        return *_root;
+    }
+
+    const JsonNode *operator->() const {
+        return _root;
+    }
+
+    const JsonNode &operator*() const {
+        return *_root;
+    }
+
+    const JsonNode &operator[](std::string_view name) const {
+        return _root->at(name);
+    }
+
+    /// Get a value by its JSON Pointer, for example "/person/courses/0"
+    const JsonNode &get(std::string_view pointer) const {
+        return *value(pointer);
+    }
+
+    /// Add a value, `value` is json text, for example `{"x": 10}` or `"str"`.
+    /// Existing object members are replaced and array elements are inserted
+    /// before the specified index ("-" means the end of the array)
+    void add(std::string_view pointer, std::string_view value) {
+        add_node(pointer, parse_value(store(value)));
+    }
+
+    void add(std::string_view pointer, const JsonNode &value) {
+        add_node(pointer, copy_node(value));
+    }
+
+    /// Replace a existing value
+    void replace(std::string_view pointer, std::string_view value) {
+        replace_node(pointer, parse_value(store(value)));
+    }
+
+    void replace(std::string_view pointer, const JsonNode &value) {
+        replace_node(pointer, copy_node(value));
+    }
+
+    void remove(std::string_view pointer) {
+        if (pointer.empty()) {
+            throw std::invalid_argument{"cannot remove the root"};
+        }
+        auto location = resolve(pointer);
+        if (!location.entry) {
+            throw std::out_of_range{"path not found " + std::string{pointer}};
+        }
+        erase_child(*location.parent, index_of(location));
+        mark_modified(location);
+    }
+
+    /// Move a value to another location
+    void move(std::string_view from, std::string_view to) {
+        if (from == to) {
+            return;
+        }
+        if (to.size() > from.size() && to.starts_with(from) &&
+            to[from.size()] == '/') {
+            throw std::invalid_argument{"cannot move a value into itself"};
+        }
+        // Array elements are moved by remove(), so take the value out first
+        auto source = value(from);
+        auto node = make_node({});
+        move_node(node, source);
+        remove(from);
+        add_node(to, node);
+    }
+
+    void copy(std::string_view from, std::string_view to) {
+        add_node(to, copy_node(*value(from)));
+    }
+
+    /// Check if the value at the location is equal to `value`
+    bool test(std::string_view pointer, const JsonNode &value) const {
+        auto location = resolve(pointer, false);
+        if (!pointer.empty() && !location.entry) {
+            return false;
+        }
+        return json_internal::equal(*entry_value(location), value);
+    }
+
+    /// Change the name of a object member
+    void rename(std::string_view pointer, std::string_view new_key) {
+        auto location = resolve(pointer);
+        if (!location.entry ||
+            location.parent->value().type != TokenType::BEGIN_OBJECT) {
+            throw std::out_of_range{"key not found " + std::string{pointer}};
+        }
+        for (auto key = location.parent->children(); key;
+             key = key->next()) {
+            if (key != location.entry &&
+                json_internal::key_equals(*key, new_key)) {
+                throw std::invalid_argument{"key " + std::string{new_key} +
+                                            " already exists"};
+            }
+        }
+        save(location.entry);
+        location.entry->value(Token{TokenType::KEY, store_escaped(new_key)});
+        mark_modified(location);
+    }
+
+    /// Apply a JSON Patch (RFC 6902). The patch is applied atomically: if any
+    /// of the operations fails, all changes are reverted and the error is
+    /// rethrown
+    void apply_patch(const JsonNode &patch) {
+        if (patch.value().type != TokenType::BEGIN_ARRAY) {
+            throw std::invalid_argument{"json patch must be an array"};
+        }
+
+        _undo.clear();
+        _undo_marks.clear();
+        _undo_root = _root;
+        _is_recording = true;
+
+        try {
+            for (auto &operation : patch) {
+                apply_operation(operation);
+            }
+        }
+        catch (...) {
+            rollback();
+            throw;
+        }
+
+        _is_recording = false;
+    }
+
+    void apply_patch(std::string_view patch) {
+        auto root = parse_json(patch);
+        apply_patch(*root);
+    }
+
+    /// Returns true if the node or anything in it has been changed, which means
+    /// that the source text of the node can not be used to represent it
+    bool is_modified(const JsonNode &node) const {
+        return _modified.contains(&node);
+    }
+
+private:
+    /// The result of looking up a JSON Pointer. The last reference token is
+    /// looked up in `parent`
+    struct Location {
+        /// The object or array, or null for the root
+        JsonNode *parent = nullptr;
+
+        /// Key node for objects and element for arrays, null if not found
+        JsonNode *entry = nullptr;
+
+        /// The unescaped last reference token
+        std::string key;
+
+        /// All containers from the root to `parent`
+        std::vector<JsonNode *> path;
+    };
+
+    struct UndoEntry {
+        JsonNode *node;
+        Token value;
+        const JsonNode *children;
+        const JsonNode *next;
+        size_t size;
+    };
+
+    /// The index in a array of `size` elements, which is `size` for "-".
+    /// Anything that is not a RFC 6901 index (digits without leading zeros),
+    /// or does not fit, is returned as npos so that it is out of range
+    static size_t array_index(std::string_view token, size_t size) {
+        constexpr auto npos = std::string_view::npos;
+        if (token == "-") {
+            return size;
+        }
+        if (token.empty() || (token.size() > 1 && token.front() == '0') ||
+            !json_internal::is_digit(token.front())) {
+            return npos;
+        }
+        size_t index = 0;
+        auto result =
+            std::from_chars(token.data(), token.data() + token.size(), index);
+        if (result.ec != std::errc{} ||
+            result.ptr != token.data() + token.size()) {
+            return npos;
+        }
+        return index;
+    }
+
+    /// Find the entry for the last reference token in the pointer. All other
+    /// tokens needs to exist
+    Location resolve(std::string_view pointer,
+                     bool should_throw = true) const {
+        auto location = Location{};
+        if (pointer.empty()) {
+            return location;
+        }
+        if (pointer.front() != '/') {
+            throw std::invalid_argument{"json pointer must start with '/': " +
+                                        std::string{pointer}};
+        }
+
+        auto current = _root;
+        pointer.remove_prefix(1);
+
+        while (true) {
+            auto end = pointer.find('/');
+            location.key =
+                json_internal::unescape_reference(pointer.substr(0, end));
+            location.parent = current;
+            location.path.push_back(current);
+            location.entry = nullptr;
+
+            auto type = current->value().type;
+            auto child = const_cast<JsonNode *>(current->children());
+            if (type == TokenType::BEGIN_OBJECT) {
+                for (; child; child = const_cast<JsonNode *>(child->next())) {
+                    if (json_internal::key_equals(*child, location.key)) {
+                        location.entry = child;
+                        break;
+                    }
+                }
+            }
+            else if (type == TokenType::BEGIN_ARRAY) {
+                // Elements are placed after each other so no need to walk
+                auto size = static_cast<size_t>(current->size());
+                auto index = array_index(location.key, size);
+                if (index > size) {
+                    if (should_throw) {
+                        throw std::out_of_range{"array index out of range " +
+                                                location.key};
+                    }
+                    index = size;
+                }
+                if (index < size) {
+                    location.entry = child + index;
+                }
+            }
+            else {
+                throw std::invalid_argument{"cannot index into a value"};
+            }
+
+            if (end == std::string_view::npos) {
+                return location;
+            }
+
+            if (!location.entry) {
+                if (should_throw) {
+                    throw std::out_of_range{"path not found " + location.key};
+                }
+                return location;
+            }
+            current = entry_value(location);
+            pointer.remove_prefix(end + 1);
+        }
+    }
+
+    JsonNode *entry_value(const Location &location) const {
+        if (!location.parent) {
+            return _root;
+        }
+        if (location.parent->value().type == TokenType::BEGIN_OBJECT) {
+            return const_cast<JsonNode *>(location.entry->children());
+        }
+        return location.entry;
+    }
+
+    JsonNode *value(std::string_view pointer) const {
+        auto location = resolve(pointer);
+        if (location.parent && !location.entry) {
+            throw std::out_of_range{"path not found " + std::string{pointer}};
+        }
+        return entry_value(location);
+    }
+
+    void add_node(std::string_view pointer, JsonNode *value) {
+        save(value);
+        value->next(nullptr);
+
+        if (pointer.empty()) {
+            set_root(value);
+            return;
+        }
+
+        auto location = resolve(pointer);
+        auto &parent = *location.parent;
+        if (parent.value().type == TokenType::BEGIN_OBJECT) {
+            if (location.entry) {
+                save(location.entry);
+                location.entry->children(value);
+            }
+            else {
+                auto key = JsonNode{
+                    Token{TokenType::KEY, store_escaped(location.key)}};
+                key.children(value);
+                insert_child(parent, index_of(location), &key);
+            }
+        }
+        else {
+            insert_child(parent, index_of(location), value);
+        }
+        mark_modified(location);
+    }
+
+    void replace_node(std::string_view pointer, JsonNode *value) {
+        if (pointer.empty()) {
+            set_root(value);
+            return;
+        }
+
+        auto location = resolve(pointer);
+        if (!location.entry) {
+            throw std::out_of_range{"path not found " + std::string{pointer}};
+        }
+        if (location.parent->value().type == TokenType::BEGIN_OBJECT) {
+            save(location.entry);
+            location.entry->children(value);
+        }
+        else {
+            // Replace the element in place to keep its position in the array
+            save(location.entry);
+            auto next = location.entry->next();
+            *location.entry = std::move(*value);
+            location.entry->next(next);
+            if (is_modified(*value)) {
+                mark(location.entry);
+            }
+        }
+        mark_modified(location);
+    }
+
+    void set_root(JsonNode *value) {
+        _root = value;
+    }
+
+    /// The position of the entry in the children of the parent, or the size
+    /// if there is no entry
+    static size_t index_of(const Location &location) {
+        if (!location.entry) {
+            return location.parent->size();
+        }
+        return static_cast<size_t>(location.entry -
+                                   location.parent->children());
+    }
+
+    /// The number of children that fit in the block starting at `children`
+    size_t capacity(const JsonNode *children, size_t size) const {
+        if (auto it = _capacities.find(children); it != _capacities.end()) {
+            return it->second;
+        }
+        return size;
+    }
+
+    /// Get a block for at least `size` children, with room to grow
+    JsonNode *allocate_block(size_t size) {
+        auto capacity = std::bit_ceil(std::max(size, size_t{4}));
+        if (auto &spare = _spare_blocks[capacity]; !spare.empty()) {
+            auto block = spare.back();
+            spare.pop_back();
+            return block;
+        }
+        auto block = make_nodes(capacity);
+        _capacities[block] = capacity;
+        return block;
+    }
+
+    /// Reuse a block that is no longer referred to. Blocks from the parser are
+    /// not reused, and nothing is reused while recording, since rollback() can
+    /// refer to the block again
+    void release_block(const JsonNode *block) {
+        auto it = _capacities.find(block);
+        if (_is_recording || it == _capacities.end()) {
+            return;
+        }
+        _spare_blocks[it->second].push_back(const_cast<JsonNode *>(block));
+    }
+
+    /// Move the content of a node to another address
+    void move_node(JsonNode *to, JsonNode *from) {
+        *to = std::move(*from);
+        if (is_modified(*from)) {
+            mark(to);
+        }
+    }
+
+    /// Link the children from `first` to the end to the child after them
+    static void relink(JsonNode *children, size_t size, size_t first) {
+        for (auto i = first; i < size; ++i) {
+            children[i].next(i + 1 < size ? children + i + 1 : nullptr);
+        }
+    }
+
+    /// Move `node` into the children of `parent` at `index`. The children stay
+    /// after each other in a block with spare capacity, so the children after
+    /// `index` are moved one step and a full block is replaced by one twice as
+    /// large. The nodes that are changed are saved for rollback()
+    void insert_child(JsonNode &parent, size_t index, JsonNode *node) {
+        auto size = parent.size();
+        auto children = const_cast<JsonNode *>(parent.children());
+        auto first = index > 0 ? index - 1 : 0; // The first link that changes
+        if (size == capacity(children, size)) {
+            // The old block is left intact for rollback()
+            auto block = allocate_block(size + 1);
+            for (size_t i = 0; i < size; ++i) {
+                move_node(block + (i < index ? i : i + 1), children + i);
+            }
+            release_block(children);
+            children = block;
+            first = 0;
+        }
+        else {
+            for (auto i = size; i > index; --i) {
+                save(children + i);
+                move_node(children + i, children + i - 1);
+            }
+            save(children + first);
+        }
+        save(children + index);
+        move_node(children + index, node);
+        relink(children, size + 1, first);
+        save(&parent);
+        parent.children(children, size + 1);
+    }
+
+    void erase_child(JsonNode &parent, size_t index) {
+        auto size = parent.size();
+        auto children = const_cast<JsonNode *>(parent.children());
+        save(&parent);
+        if (size == 1) {
+            parent.children(nullptr, 0);
+            release_block(children);
+            return;
+        }
+        auto first = index > 0 ? index - 1 : 0; // The first link that changes
+        save(children + first);
+        for (auto i = index; i + 1 < size; ++i) {
+            save(children + i);
+            move_node(children + i, children + i + 1);
+        }
+        relink(children, size - 1, first);
+        parent.children(children, size - 1);
+    }
+
+    void mark(const JsonNode *node) {
+        if (_modified.insert(node).second && _is_recording) {
+            _undo_marks.push_back(node);
+        }
+    }
+
+    void mark_modified(const Location &location) {
+        for (auto node : location.path) {
+            mark(node);
+        }
+    }
+
+    void apply_operation(const JsonNode &operation) {
+        auto op = operation.at("op").str();
+        auto path = operation.at("path").str();
+
+        if (op == "add") {
+            add(path, operation.at("value"));
+        }
+        else if (op == "remove") {
+            remove(path);
+        }
+        else if (op == "replace") {
+            replace(path, operation.at("value"));
+        }
+        else if (op == "move") {
+            move(operation.at("from").str(), path);
+        }
+        else if (op == "copy") {
+            copy(operation.at("from").str(), path);
+        }
+        else if (op == "test") {
+            if (!test(path, operation.at("value"))) {
+                throw std::runtime_error{"json patch test failed for " +
+                                         path};
+            }
+        }
+        else {
+            throw std::invalid_argument{"unknown json patch operation " + op};
+        }
+    }
+
+    /// Remember the state of a node so that a failed patch can be reverted
+    void save(JsonNode *node) {
+        if (_is_recording) {
+            _undo.push_back({node,
+                             node->value(),
+                             node->children(),
+                             node->next(),
+                             node->size()});
+        }
+    }
+
+    void rollback() {
+        for (auto it = _undo.rbegin(); it != _undo.rend(); ++it) {
+            it->node->value(it->value);
+            it->node->children(it->children, it->size);
+            it->node->next(it->next);
+        }
+        for (auto node : _undo_marks) {
+            _modified.erase(node);
+        }
+        _root = _undo_root;
+        _undo.clear();
+        _undo_marks.clear();
+        _is_recording = false;
+    }
+
+    /// Copy a string into the arena
+    std::string_view store(std::string_view str) {
+        auto data = static_cast<char *>(_arena.allocate(str.size(), 1));
+        std::memcpy(data, str.data(), str.size());
+        return {data, str.size()};
+    }
+
+    std::string_view store_escaped(std::string_view str) {
+        auto escaped = std::string{};
+        json_internal::escape_to(escaped, str);
+        return store(escaped);
+    }
+
+    JsonNode *make_node(const Token &token) {
+        return std::pmr::polymorphic_allocator<>{&_arena}
+            .new_object<JsonNode>(token);
+    }
+
+    /// Allocate `size` nodes after each other in the arena
+    JsonNode *make_nodes(size_t size) {
+        auto nodes =
+            std::pmr::polymorphic_allocator<JsonNode>{&_arena}.allocate(size);
+        std::uninitialized_default_construct_n(nodes, size);
+        return nodes;
+    }
+
+    /// Parse json text that is kept alive by the document
+    JsonNode *parse_value(std::string_view input) {
+        auto num_nodes = json_internal::tokenize(input, _tokens, {}, _stack);
+        auto &nodes = _blocks.emplace_back(&_arena);
+        json_internal::parse_tokens(input, _tokens, num_nodes, nodes, _stack);
+        return nodes.data();
+    }
+
+    /// Deep copy a value with all its strings into the arena. The source text
+    /// of copied objects and arrays is not kept, so they are marked as
+    /// modified
+    JsonNode *copy_node(const JsonNode &source) {
+        auto node = make_node({});
+        copy_to(*node, source);
+        return node;
+    }
+
+    void copy_to(JsonNode &node, const JsonNode &source) {
+        auto type = source.value().type;
+        auto text = std::string_view{};
+        if (type == TokenType::STRING || type == TokenType::KEY) {
+            text = store(source.source());
+            text = text.substr(1, text.size() - 2);
+        }
+        else if (type == TokenType::BEGIN_OBJECT ||
+                 type == TokenType::BEGIN_ARRAY) {
+            text = source.value().value.substr(0, 1);
+        }
+        else {
+            text = store(source.value().value);
+        }
+
+        node = JsonNode{Token{type, text}};
+        if (type == TokenType::KEY) {
+            node.children(copy_node(*source.children()));
+        }
+        else if (type == TokenType::BEGIN_OBJECT ||
+                 type == TokenType::BEGIN_ARRAY) {
+            mark(&node);
+            auto children = make_nodes(source.size());
+            auto copy = children;
+            for (auto &child : source) {
+                copy_to(*copy, child);
+                copy->next(child.next() ? copy + 1 : nullptr);
+                ++copy;
+            }
+            node.children(source.size() ? children : nullptr, source.size());
+        }
+    }
+
+    std::pmr::monotonic_buffer_resource _arena;
+    std::pmr::vector<Token> _tokens;
+    json_internal::ParseStack _stack;
+    std::deque<std::pmr::vector<JsonNode>> _blocks;
+    JsonNode *_root = nullptr;
+    std::unordered_set<const JsonNode *> _modified;
+
+    /// The capacity of the blocks of children allocated by insert_child(),
+    /// and the blocks that can be reused by capacity
+    std::unordered_map<const JsonNode *, size_t> _capacities;
+    std::unordered_map<size_t, std::vector<JsonNode *>> _spare_blocks;
+
+    std::vector<UndoEntry> _undo;
+    std::vector<const JsonNode *> _undo_marks;
+    JsonNode *_undo_root = nullptr;
+    bool _is_recording = false;
+};
+
+} // namespace json
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "jsonout.h"
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace json {
+
+namespace json_internal {
+
+/// Serialize the elements [begin, end) the way they are printed by
+/// JsonOut::push_back() on a array at the indentation `indent`, with the
+/// precision, flags and locale of `format`. The text starts with the
+/// indentation of the first element and ends after the last element, without
+/// the separator
+template <typename It>
+std::string serialize_elements(It begin,
+                               It end,
+                               const std::ostream &format,
+                               int indent_width,
+                               int indent) {
+    auto ss = std::ostringstream{};
+    ss.copyfmt(format);
+    ss.imbue(format.getloc());
+    auto text = std::string{};
+    {
+        auto array = JsonOut{ss, indent_width, indent};
+        for (auto it = begin; it != end; ++it) {
+            array.push_back(*it);
+        }
+        // Take the text before the array is closed
+        text = std::move(ss).str();
+        ss.str({});
+    }
+
+    // Remove "[" and the newline that opens the array
+    text.erase(0, indent_width == -1 ? 1 : 2);
+    return text;
+}
+
+} // namespace json_internal
+
+/// Print `values` as a array on `out` where the elements are serialized on
+/// `num_threads` threads, each to its own buffer. The output is the same as
+/// for `out = values`. Use for large ranges where each element is expensive to
+/// print; small ranges are printed directly
+template <typename T>
+    requires std::ranges::random_access_range<const T>
+void write_array_parallel(
+    JsonOut &out,
+    const T &values,
+    size_t num_threads = std::thread::hardware_concurrency(),
+    size_t min_chunk_size = 1024) {
+    auto size = static_cast<size_t>(std::ranges::size(values));
+    auto num_chunks =
+        std::min(num_threads, size / std::max<size_t>(min_chunk_size, 1));
+    if (num_chunks < 2) {
+        out = values;
+        return;
+    }
+
+    auto begin = std::ranges::begin(values);
+    auto chunks = std::vector<std::string>(num_chunks);
+    auto errors = std::vector<std::exception_ptr>(num_chunks);
+    {
+        auto threads = std::vector<std::jthread>{};
+        threads.reserve(num_chunks);
+        for (size_t i = 0; i < num_chunks; ++i) {
+            threads.emplace_back([&, i] {
+                try {
+                    auto first =
+                        static_cast<std::ptrdiff_t>(size * i / num_chunks);
+                    auto last = static_cast<std::ptrdiff_t>(size * (i + 1) /
+                                                            num_chunks);
+                    chunks[i] = json_internal::serialize_elements(
+                        begin + first,
+                        begin + last,
+                        out.stream(),
+                        out.indent_width(),
+                        out.indent());
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+    }
+
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // push_back_serialized() prints the separator between the chunks
+    for (auto &chunk : chunks) {
+        out.push_back_serialized(chunk);
+    }
+}
+
+} // namespace json
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "document.h"
+#include "mutabledocument.h"
+#include "simd.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/// Selects NDJSON records by the values of their fields. Each record is first
+/// tested on its raw bytes: the quoted keys of each path and the value (for
+/// strings, booleans and null) must be in the text. The few records that
+/// passes are parsed and compared with json_internal::equal(), so the result
+/// is the same as when all records are parsed.
+///
+/// Records that contains escapes are always parsed, since the text can differ
+/// from the value. Only "\u" escapes count, unless a key or value contains a
+/// character that can be escaped in another way
+class RecordFilter {
+public:
+    /// Only keep records where the value at `path` (a JSON Pointer through
+    /// objects) is equal to `value`, which is json text. Can be called
+    /// multiple times to require all of the conditions
+    RecordFilter &equals(std::string_view path, std::string_view value) {
+        auto condition = Condition{};
+        condition.value = Document::parse(std::string{value});
+
+        if (!path.empty() && path.front() != '/') {
+            throw std::invalid_argument{"json pointer must start with '/': " +
+                                        std::string{path}};
+        }
+        while (!path.empty()) {
+            path.remove_prefix(1);
+            auto end = path.find('/');
+            condition.keys.push_back(
+                json_internal::unescape_reference(path.substr(0, end)));
+            path.remove_prefix(std::min(end, path.size()));
+            _key_needles.push_back(quoted(condition.keys.back()));
+        }
+
+        auto &node = condition.value->root();
+        switch (node.value().type) {
+        case TokenType::STRING:
+            _value_needles.push_back(quoted(node.str()));
+            break;
+        case TokenType::BOOLEAN:
+        case TokenType::NULL_VALUE:
+            _value_needles.emplace_back(node.value().value);
+            break;
+        default:
+            // Numbers can be written in many ways, and containers may
+            // contain whitespace
+            break;
+        }
+
+        _conditions.push_back(std::move(condition));
+
+        // Values are more rare than keys, and long needles more than short
+        auto by_size = [](auto &a, auto &b) { return a.size() > b.size(); };
+        std::sort(_value_needles.begin(), _value_needles.end(), by_size);
+        std::sort(_key_needles.begin(), _key_needles.end(), by_size);
+        return *this;
+    }
+
+    /// Test the raw text of a record. False means that the record does not
+    /// match, true that it needs to be parsed to tell
+    bool may_match(std::string_view record) const {
+        if (contains(record, escape_needle())) {
+            return true;
+        }
+        for (auto needles : {&_value_needles, &_key_needles}) {
+            for (auto &needle : *needles) {
+                if (!contains(record, needle)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// Test a parsed record
+    bool matches(const JsonNode &record) const {
+        for (auto &condition : _conditions) {
+            auto node = &record;
+            for (auto &key : condition.keys) {
+                node = find(*node, key);
+                if (!node) {
+                    return false;
+                }
+            }
+            if (!json_internal::equal(*node, condition.value->root())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Test a record with may_match() and then by parsing it
+    bool matches(std::string_view record) const {
+        return may_match(record) && matches(*parse_json(record));
+    }
+
+    /// The needle that is searched for in whole buffers (see
+    /// for_each_matching_record())
+    std::string_view primary_needle() const {
+        if (!_value_needles.empty()) {
+            return _value_needles.front();
+        }
+        return _key_needles.empty() ? std::string_view{}
+                                    : _key_needles.front();
+    }
+
+    std::string_view escape_needle() const {
+        return _has_escapable_needle ? "\\" : "\\u";
+    }
+
+private:
+    struct Condition {
+        std::vector<std::string> keys;
+        std::shared_ptr<const Document> value;
+    };
+
+    static bool contains(std::string_view text, std::string_view needle) {
+        auto end = text.data() + text.size();
+        return json_internal::find_substring(text.data(), end, needle) != end;
+    }
+
+    static const JsonNode *find(const JsonNode &node, std::string_view key) {
+        if (node.value().type != TokenType::BEGIN_OBJECT) {
+            return nullptr;
+        }
+        for (auto &child : node) {
+            if (json_internal::key_equals(child, key)) {
+                return child.children();
+            }
+        }
+        return nullptr;
+    }
+
+    /// A string as it is written in json
+    std::string quoted(std::string_view str) {
+        auto needle = std::string{"\""};
+        json_internal::escape_to(needle, str);
+        needle += "\"";
+        if (needle.find('\\') != std::string::npos ||
+            str.find('/') != std::string_view::npos) {
+            // "\/" is also a valid way to write "/"
+            _has_escapable_needle = true;
+        }
+        return needle;
+    }
+
+    std::vector<Condition> _conditions;
+    std::vector<std::string> _value_needles;
+    std::vector<std::string> _key_needles;
+    bool _has_escapable_needle = false;
+};
+
+/// Call `f(record, node)` for each record in NDJSON text that matches the
+/// filter. Instead of testing each line, the whole text is searched for the
+/// primary needle of the filter (and for escapes), so lines that can not match
+/// are skipped without being looked at. Only the remaining lines are parsed.
+/// The node is valid during the call
+template <typename F>
+void for_each_matching_record(std::string_view input,
+                              const RecordFilter &filter,
+                              F f) {
+    auto data = input.data();
+    auto size = input.size();
+    auto find = [&](std::string_view needle, size_t pos) {
+        return static_cast<size_t>(
+            json_internal::find_substring(data + pos, data + size, needle) -
+            data);
+    };
+
+    auto parser = Parser{};
+    size_t hit = 0;
+    size_t escape = 0;
+    auto primary = filter.primary_needle();
+    auto escape_needle = filter.escape_needle();
+
+    for (size_t pos = 0; pos < size;) {
+        // The positions found earlier are kept until they are passed
+        if (primary.empty()) {
+            hit = pos;
+        }
+        else if (hit < pos || pos == 0) {
+            hit = find(primary, pos);
+        }
+        if (escape < pos || pos == 0) {
+            escape = find(escape_needle, pos);
+        }
+        auto candidate = std::min(hit, escape);
+        if (candidate >= size) {
+            break;
+        }
+
+        auto begin = pos;
+        if (candidate > pos) {
+            auto newline = input.rfind('\n', candidate - 1);
+            if (newline != std::string_view::npos && newline >= pos) {
+                begin = newline + 1;
+            }
+        }
+        auto end = static_cast<size_t>(
+            json_internal::find_any<'\n'>(data + candidate, data + size) -
+            data);
+        auto record = input.substr(begin, end - begin);
+        pos = end + 1;
+
+        if (json_internal::skip_whitespace(record.data(),
+                                           record.data() + record.size()) ==
+                record.data() + record.size() ||
+            !filter.may_match(record)) {
+            continue;
+        }
+        auto &root = parser.parse(record);
+        if (filter.matches(*root)) {
+            f(record, *root);
+        }
+    }
+}
+
+} // namespace json
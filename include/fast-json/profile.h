@@ -0,0 +1,385 @@
+#pragma once
+
+#include "jsonnode.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace json {
+
+/// What is known about the values at one path in the profiled documents
+struct PathProfile {
+    /// A JSON Pointer, where "*" stands for any element of an array
+    std::string path;
+
+    /// The number of values at the path
+    size_t count = 0;
+
+    /// The number of values that were read at least once
+    size_t num_read = 0;
+
+    /// The number of calls that read the values. Reading a value with
+    /// `root["id"].number()` counts as two: at() that finds it and number()
+    size_t accesses = 0;
+
+    /// The size of the values in the text
+    size_t bytes = 0;
+
+    /// The size of the values that were read
+    size_t read_bytes = 0;
+
+    size_t unused_bytes() const {
+        return bytes - read_bytes;
+    }
+};
+
+/// The result of the profiling, see AccessProfiler
+struct AccessReport {
+    size_t documents = 0;
+
+    /// The size of the parsed documents
+    size_t bytes = 0;
+
+    /// The size of the values that were read at the used_paths(). Reading
+    /// only the values in an object does not count the rest of the object
+    size_t used_bytes = 0;
+
+    /// Sorted by path, so that a value comes before the values in it
+    std::vector<PathProfile> paths;
+
+    size_t wasted_bytes() const {
+        return bytes - used_bytes;
+    }
+
+    const PathProfile *find(std::string_view path) const {
+        auto it = std::lower_bound(
+            paths.begin(), paths.end(), path, [](auto &profile, auto path) {
+                return profile.path < path;
+            });
+        return it != paths.end() && it->path == path ? &*it : nullptr;
+    }
+
+    /// The paths that were read, except those that are only on the way to
+    /// other paths that were read. Paths without "*" can be used directly
+    /// as ColumnSpec paths for extract_columns() or with a RecordFilter
+    std::vector<std::string> used_paths() const {
+        auto result = std::vector<std::string>{};
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (!paths[i].accesses) {
+                continue;
+            }
+            auto prefix = paths[i].path + "/";
+            auto is_leaf = true;
+            for (size_t j = i + 1; j < paths.size(); ++j) {
+                if (paths[j].path.compare(0, prefix.size(), prefix) != 0) {
+                    // Not sorted next to each other if a key contains a
+                    // character that sorts before '/'
+                    continue;
+                }
+                if (paths[j].accesses) {
+                    is_leaf = false;
+                    break;
+                }
+            }
+            if (is_leaf) {
+                result.push_back(paths[i].path);
+            }
+        }
+        return result;
+    }
+
+    /// A table with one line per path
+    std::string to_string() const {
+        auto percent = [](size_t part, size_t total) {
+            return total ? 100.0 * static_cast<double>(part) /
+                               static_cast<double>(total)
+                         : 0.0;
+        };
+        auto out = std::ostringstream{};
+        out << std::fixed << std::setprecision(1);
+        out << documents << " documents, " << bytes << " bytes, "
+            << used_bytes << " bytes used (" << percent(used_bytes, bytes)
+            << "%), " << wasted_bytes() << " bytes wasted\n";
+        out << std::left << std::setw(40) << "path" << std::right
+            << std::setw(10) << "count" << std::setw(10) << "read %"
+            << std::setw(12) << "accesses" << std::setw(14) << "bytes"
+            << std::setw(14) << "unused bytes" << "\n";
+        for (auto &profile : paths) {
+            out << std::left << std::setw(40)
+                << (profile.path.empty() ? "(root)" : profile.path)
+                << std::right << std::setw(10) << profile.count
+                << std::setw(10) << percent(profile.num_read, profile.count)
+                << std::setw(12) << profile.accesses << std::setw(14)
+                << profile.bytes << std::setw(14) << profile.unused_bytes()
+                << "\n";
+        }
+        return out.str();
+    }
+};
+
+namespace json_internal {
+
+/// The counts of one path
+struct PathCounts {
+    size_t count = 0;
+    size_t num_read = 0;
+    size_t accesses = 0;
+    size_t bytes = 0;
+    size_t read_bytes = 0;
+};
+
+/// The statistics collected by one thread, indexed by the path id
+struct ProfileShard {
+    std::mutex mutex;
+    std::vector<PathCounts> paths;
+    size_t documents = 0;
+    size_t bytes = 0;
+
+    /// The ids of the paths that the thread has seen, by path_key(), to not
+    /// have to lock the profiler for each value
+    std::unordered_map<std::string, uint32_t> ids;
+
+    PathCounts &at(uint32_t id) {
+        if (id >= paths.size()) {
+            paths.resize(id + 1);
+        }
+        return paths[id];
+    }
+};
+
+/// A path is stored as the path it is in and the last part, like "/key" or
+/// "/*", so that the size does not grow with the depth of the documents
+struct PathPart {
+    uint32_t parent;
+    std::string last;
+};
+
+inline std::string path_key(uint32_t parent, std::string_view last) {
+    auto key = std::string(sizeof(parent), '\0');
+    std::memcpy(key.data(), &parent, sizeof(parent));
+    key += last;
+    return key;
+}
+
+} // namespace json_internal
+
+/// Collects which values of the parsed documents that are read. Build with
+/// FAST_JSON_PROFILE_ACCESS defined, for all files in the program, to make
+/// the parsed documents profiled and JsonNode count the reads by at(),
+/// find(), visit(), number(), boolean(), raw() and str().
+///
+/// When a document is parsed, each value gets the id of its path, so reading
+/// it does not depend on the text still being there. Each thread adds to its
+/// own statistics, so threads only wait for each other when a new path is
+/// seen or report() is called. Values that are parsed into a larger document
+/// (by MutableDocument or IncrementalDocument) are counted as documents of
+/// their own
+class AccessProfiler {
+public:
+    static AccessProfiler &global() {
+        static auto profiler = AccessProfiler{};
+        return profiler;
+    }
+
+    AccessProfiler(const AccessProfiler &) = delete;
+    AccessProfiler &operator=(const AccessProfiler &) = delete;
+
+    void enable(bool is_enabled = true) {
+        _is_enabled.store(is_enabled, std::memory_order_relaxed);
+    }
+
+    bool is_enabled() const {
+        return _is_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Count the values of a document and give them their path ids, which is
+    /// done by the parser
+    void add_document(const JsonNode &root) {
+        if (!is_enabled()) {
+            return;
+        }
+        auto &shard = local_shard();
+        auto lock = std::unique_lock{shard.mutex};
+        ++shard.documents;
+        shard.bytes += root.source().size();
+        add_node(shard, root);
+    }
+
+    /// Count a read of a value, see JsonNode::record_access()
+    void add_access(uint32_t id, bool is_first, size_t size) {
+        if (!is_enabled()) {
+            return;
+        }
+        auto &shard = local_shard();
+        auto lock = std::unique_lock{shard.mutex};
+        auto &counts = shard.at(id);
+        ++counts.accesses;
+        if (is_first) {
+            ++counts.num_read;
+            counts.read_bytes += size;
+        }
+    }
+
+    /// Merge the statistics of all threads
+    AccessReport report() const {
+        auto report = AccessReport{};
+        auto lock = std::unique_lock{_mutex};
+        auto sums = std::vector<json_internal::PathCounts>(_parts.size());
+        for (auto &shard : _shards) {
+            auto shard_lock = std::unique_lock{shard->mutex};
+            report.documents += shard->documents;
+            report.bytes += shard->bytes;
+            for (size_t id = 0; id < shard->paths.size(); ++id) {
+                auto &counts = shard->paths[id];
+                sums[id].count += counts.count;
+                sums[id].num_read += counts.num_read;
+                sums[id].accesses += counts.accesses;
+                sums[id].bytes += counts.bytes;
+                sums[id].read_bytes += counts.read_bytes;
+            }
+        }
+        // The parents have lower ids
+        auto names = std::vector<std::string>(_parts.size());
+        for (size_t id = root_id; id < sums.size(); ++id) {
+            auto &part = _parts[id];
+            names[id] = names[part.parent] + part.last;
+            auto &sum = sums[id];
+            if (sum.count || sum.accesses) {
+                report.paths.push_back({names[id],
+                                        sum.count,
+                                        sum.num_read,
+                                        sum.accesses,
+                                        sum.bytes,
+                                        sum.read_bytes});
+            }
+        }
+        std::sort(report.paths.begin(),
+                  report.paths.end(),
+                  [](auto &a, auto &b) { return a.path < b.path; });
+        for (auto &path : report.used_paths()) {
+            report.used_bytes += report.find(path)->read_bytes;
+        }
+        return report;
+    }
+
+    /// Clear the statistics. Documents that are already parsed are still
+    /// profiled
+    void reset() {
+        auto lock = std::unique_lock{_mutex};
+        for (auto &shard : _shards) {
+            auto shard_lock = std::unique_lock{shard->mutex};
+            shard->paths.clear();
+            shard->documents = 0;
+            shard->bytes = 0;
+        }
+    }
+
+private:
+    AccessProfiler() = default;
+
+    json_internal::ProfileShard &local_shard() {
+        // The shards are kept when the threads exit, so that the statistics
+        // are in the report
+        thread_local json_internal::ProfileShard *shard = nullptr;
+        if (!shard) {
+            auto lock = std::unique_lock{_mutex};
+            shard = _shards
+                        .emplace_back(
+                            std::make_unique<json_internal::ProfileShard>())
+                        .get();
+        }
+        return *shard;
+    }
+
+    uint32_t path_id(json_internal::ProfileShard &shard,
+                     uint32_t parent,
+                     std::string_view last) {
+        auto key = json_internal::path_key(parent, last);
+        if (auto it = shard.ids.find(key); it != shard.ids.end()) {
+            return it->second;
+        }
+        auto lock = std::unique_lock{_mutex};
+        auto [it, is_new] =
+            _ids.try_emplace(key, static_cast<uint32_t>(_parts.size()));
+        if (is_new) {
+            if (_parts.size() == is_read_bit) {
+                throw std::runtime_error{"too many paths to profile"};
+            }
+            _parts.push_back({parent, std::string{last}});
+        }
+        shard.ids.emplace(std::move(key), it->second);
+        return it->second;
+    }
+
+    // Not recursive, since documents can be nested deeper than the stack
+    void add_node(json_internal::ProfileShard &shard, const JsonNode &root) {
+        struct Item {
+            const JsonNode *node;
+            uint32_t id;
+        };
+        auto stack = std::vector<Item>{{&root, root_id}};
+        auto last = std::string{};
+        while (!stack.empty()) {
+            auto [node, id] = stack.back();
+            stack.pop_back();
+            switch (node->value().type) {
+            case TokenType::BEGIN_OBJECT:
+                for (auto &key : *node) {
+                    if (!key.children()) {
+                        // A key without a value, accepted in lenient mode
+                        continue;
+                    }
+                    last.clear();
+                    json_internal::append_pointer_token(last,
+                                                        key.value().value);
+                    stack.push_back({key.children(), path_id(shard, id, last)});
+                }
+                break;
+            case TokenType::BEGIN_ARRAY:
+                for (auto &element : *node) {
+                    stack.push_back({&element, path_id(shard, id, "/*")});
+                }
+                break;
+            default:
+                break;
+            }
+
+            auto &counts = shard.at(id);
+            ++counts.count;
+            counts.bytes += node->source().size();
+            node->_profile_id = id;
+        }
+    }
+
+    static constexpr auto is_read_bit = uint32_t{1} << 31;
+
+    // Id 0 is for values that are not profiled
+    static constexpr auto root_id = uint32_t{1};
+
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<json_internal::ProfileShard>> _shards;
+
+    std::vector<json_internal::PathPart> _parts{{0, ""}, {0, ""}};
+    std::unordered_map<std::string, uint32_t> _ids;
+    std::atomic<bool> _is_enabled = true;
+};
+
+namespace json_internal {
+
+inline void record_profiled_access(uint32_t id, bool is_first, size_t size) {
+    AccessProfiler::global().add_access(id, is_first, size);
+}
+
+} // namespace json_internal
+
+} // namespace json
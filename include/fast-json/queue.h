@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+namespace json {
+
+namespace json_internal {
+
+/// A bounded queue between producing and consuming threads. Closing the queue
+/// wakes up everyone that waits: producers stop and consumers get the
+/// remaining items, and then the error of the first close() that had one
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t max_size)
+        : _max_size{max_size} {}
+
+    /// Returns false if the queue is closed
+    bool push(T item) {
+        auto lock = std::unique_lock{_mutex};
+        _not_full.wait(
+            lock, [&] { return _items.size() < _max_size || _is_closed; });
+        if (_is_closed) {
+            return false;
+        }
+        _items.push_back(std::move(item));
+        _not_empty.notify_one();
+        return true;
+    }
+
+    /// Returns false when the queue is closed and empty. Rethrows if a
+    /// producer failed
+    bool pop(T &item) {
+        auto lock = std::unique_lock{_mutex};
+        _not_empty.wait(lock, [&] { return !_items.empty() || _is_closed; });
+        if (_items.empty()) {
+            if (_error) {
+                std::rethrow_exception(_error);
+            }
+            return false;
+        }
+        item = std::move(_items.front());
+        _items.pop_front();
+        _not_full.notify_one();
+        return true;
+    }
+
+    void close(std::exception_ptr error = {}) {
+        auto lock = std::unique_lock{_mutex};
+        _is_closed = true;
+        if (!_error) {
+            _error = error;
+        }
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _not_empty;
+    std::condition_variable _not_full;
+    std::deque<T> _items;
+    size_t _max_size;
+    bool _is_closed = false;
+    std::exception_ptr _error;
+};
+
+} // namespace json_internal
+
+} // namespace json
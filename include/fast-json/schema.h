@@ -0,0 +1,393 @@
+#pragma once
+
+#include "fixedstring.h"
+#include "json.h"
+#include "lineindex.h"
+#include "simd.h"
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace json {
+
+/// Describes one member of a struct in a Schema
+template <fixed_string Name, auto Member>
+struct field {
+    static constexpr auto name = Name;
+    static constexpr auto member = Member;
+};
+
+/// Specialize this to make a type usable as a value in another schema or
+/// with parse_as(), for example
+///
+///   template <>
+///   struct json::schema_for<Point>
+///       : json::Schema<Point, json::field<"x", &Point::x>,
+///                             json::field<"y", &Point::y>> {};
+template <typename T>
+struct schema_for;
+
+namespace json_internal {
+
+template <typename T>
+concept HasSchema = requires { typename schema_for<T>::type; };
+
+template <typename T>
+struct is_optional : std::false_type {};
+
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename C, typename M>
+C member_class(M C::*);
+
+template <typename C, typename M>
+M member_type(M C::*);
+
+/// Reads json text directly into native values, without creating tokens or
+/// nodes. Used by Schema, where the expected type of each value is known
+class SchemaReader {
+public:
+    explicit SchemaReader(std::string_view input, size_t pos = 0)
+        : _input{input}
+        , _pos{pos} {}
+
+    size_t position() const {
+        return _pos;
+    }
+
+    /// The next character that is not whitespace, or 0 at the end
+    char peek() {
+        auto begin = _input.data();
+        auto p = skip_whitespace(begin + _pos, begin + _input.size());
+        _pos = static_cast<size_t>(p - begin);
+        return _pos < _input.size() ? _input[_pos] : 0;
+    }
+
+    bool consume(char c) {
+        if (peek() == c) {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            error(std::string{"expected '"} + c + "'");
+        }
+    }
+
+    bool consume_null() {
+        if (peek() != 'n') {
+            return false;
+        }
+        expect_literal("null");
+        return true;
+    }
+
+    /// The content of a string without quotes and with the escapes left
+    std::string_view read_raw_string() {
+        expect('\"');
+        auto begin = _input.data();
+        auto start = _pos;
+        while (true) {
+            auto p = find_any<'\"', '\\'>(begin + _pos, begin + _input.size());
+            _pos = static_cast<size_t>(p - begin);
+            if (_pos >= _input.size() ||
+                (*p == '\\' && _pos + 1 >= _input.size())) {
+                _pos = start - 1;
+                error("unterminated string");
+            }
+            if (*p == '\"') {
+                return _input.substr(start, _pos++ - start);
+            }
+            _pos += 2;
+        }
+    }
+
+    template <typename T>
+    void read(T &value) {
+        if constexpr (HasSchema<T>) {
+            schema_for<T>::read(*this, value);
+        }
+        else if constexpr (is_optional<T>::value) {
+            if (consume_null()) {
+                value.reset();
+            }
+            else {
+                read(value.emplace());
+            }
+        }
+        else if constexpr (std::is_same_v<T, bool>) {
+            if (peek() == 't') {
+                expect_literal("true");
+                value = true;
+            }
+            else {
+                expect_literal("false");
+                value = false;
+            }
+        }
+        else if constexpr (std::is_arithmetic_v<T>) {
+            read_number(value);
+        }
+        else if constexpr (JsonString<T>) {
+            if (peek() != '\"') {
+                error("expected string");
+            }
+            auto raw = read_raw_string();
+            value.clear();
+            JsonNode{Token{TokenType::STRING, raw}}.unescape_to(value);
+        }
+        else if constexpr (JsonSequence<T>) {
+            if (peek() != '[') {
+                error("expected array");
+            }
+            expect('[');
+            value.clear();
+            if (consume(']')) {
+                return;
+            }
+            do {
+                value.emplace_back();
+                read(value.back());
+            } while (consume(','));
+            expect(']');
+        }
+        else {
+            static_assert(!sizeof(T), "type is not supported by schemas");
+        }
+    }
+
+    /// Skip a value of any type, used for keys that is not in the schema. The
+    /// grammar of the value is checked, but strings are not unescaped. The
+    /// closing brackets of the open containers are kept in a string, so the
+    /// nesting is not limited by the call stack
+    void skip_value() {
+        auto open = std::string{};
+        while (true) {
+            switch (peek()) {
+            case '{':
+                ++_pos;
+                if (!consume('}')) {
+                    open.push_back('}');
+                    skip_key();
+                    continue;
+                }
+                break;
+            case '[':
+                ++_pos;
+                if (!consume(']')) {
+                    open.push_back(']');
+                    continue;
+                }
+                break;
+            case '\"':
+                read_raw_string();
+                break;
+            case 't':
+                expect_literal("true");
+                break;
+            case 'f':
+                expect_literal("false");
+                break;
+            case 'n':
+                expect_literal("null");
+                break;
+            case 0:
+                error("unexpected end of input");
+            default: {
+                auto start = _pos;
+                if (!is_valid_number(scan_number())) {
+                    _pos = start;
+                    error("invalid number");
+                }
+            }
+            }
+
+            // After a value the containers that end, then the next element
+            while (!open.empty() && consume(open.back())) {
+                open.pop_back();
+            }
+            if (open.empty()) {
+                return;
+            }
+            expect(',');
+            if (open.back() == '}') {
+                skip_key();
+            }
+        }
+    }
+
+    /// Check that there is nothing but whitespace left
+    void finish() {
+        if (peek()) {
+            error("unexpected content after value");
+        }
+    }
+
+    [[noreturn]] void error(const std::string &message) const {
+        auto position = std::min(_pos, _input.size());
+        throw ParseError{
+            message, position, LineIndex{_input}.location(position)};
+    }
+
+private:
+    void expect_literal(std::string_view literal) {
+        peek();
+        if (_input.substr(_pos, literal.size()) != literal) {
+            error("expected " + std::string{literal});
+        }
+        _pos += literal.size();
+    }
+
+    void skip_key() {
+        if (peek() != '\"') {
+            error("expected key");
+        }
+        read_raw_string();
+        expect(':');
+    }
+
+    /// The characters that can be part of a number, starting at the next
+    /// value
+    std::string_view scan_number() {
+        auto c = peek();
+        if (c != '-' && !is_digit(c)) {
+            error("expected number");
+        }
+        auto start = _pos;
+        while (_pos < _input.size() &&
+               (is_digit(_input[_pos]) || _input[_pos] == '-' ||
+                _input[_pos] == '+' || _input[_pos] == '.' ||
+                _input[_pos] == 'e' || _input[_pos] == 'E')) {
+            ++_pos;
+        }
+        return _input.substr(start, _pos - start);
+    }
+
+    template <typename T>
+    void read_number(T &value) {
+        auto text = scan_number();
+        auto start = static_cast<size_t>(text.data() - _input.data());
+        auto result =
+            std::from_chars(text.data(), text.data() + text.size(), value);
+        if (!is_valid_number(text) || result.ec != std::errc{} ||
+            result.ptr != text.data() + text.size()) {
+            _pos = start;
+            error(std::is_integral_v<T> ? "expected integer"
+                                        : "invalid number");
+        }
+    }
+
+    std::string_view _input;
+    size_t _pos = 0;
+};
+
+} // namespace json_internal
+
+/// A description of how a struct is represented as a json object. The keys,
+/// their types and the nesting is known at compile time, so the input is read
+/// directly into the struct without building a tree, and a value of the
+/// wrong type is rejected where it is found.
+///
+/// Members that are std::optional may be missing or null, all other members
+/// are required. Keys that are not in the schema are skipped
+template <typename T, typename... Fields>
+struct Schema {
+    using type = T;
+
+    static_assert(sizeof...(Fields) <= 64, "too many fields in schema");
+    static_assert(
+        (std::is_same_v<decltype(json_internal::member_class(Fields::member)),
+                        T> &&
+         ...),
+        "all fields must be members of the schema type");
+
+    static T parse(std::string_view input) {
+        auto value = T{};
+        parse(input, value);
+        return value;
+    }
+
+    static void parse(std::string_view input, T &value) {
+        auto reader = json_internal::SchemaReader{input};
+        read(reader, value);
+        reader.finish();
+    }
+
+    static void read(json_internal::SchemaReader &reader, T &value) {
+        if (reader.peek() != '{') {
+            reader.error("expected object");
+        }
+        reader.expect('{');
+        uint64_t found = 0;
+        if (!reader.consume('}')) {
+            do {
+                auto key = reader.read_raw_string();
+                reader.expect(':');
+                if (!read_field(reader, value, key, found,
+                                std::index_sequence_for<Fields...>{})) {
+                    reader.skip_value();
+                }
+            } while (reader.consume(','));
+            reader.expect('}');
+        }
+        check_required(reader, found, std::index_sequence_for<Fields...>{});
+    }
+
+private:
+    template <size_t... Is>
+    static bool read_field(json_internal::SchemaReader &reader,
+                           T &value,
+                           std::string_view key,
+                           uint64_t &found,
+                           std::index_sequence<Is...>) {
+        return (read_field<Is, Fields>(reader, value, key, found) || ...);
+    }
+
+    template <size_t I, typename Field>
+    static bool read_field(json_internal::SchemaReader &reader,
+                           T &value,
+                           std::string_view key,
+                           uint64_t &found) {
+        if (key != Field::name.view()) {
+            return false;
+        }
+        reader.read(value.*Field::member);
+        found |= uint64_t{1} << I;
+        return true;
+    }
+
+    template <size_t... Is>
+    static void check_required(json_internal::SchemaReader &reader,
+                               uint64_t found,
+                               std::index_sequence<Is...>) {
+        (check_required<Is, Fields>(reader, found), ...);
+    }
+
+    template <size_t I, typename Field>
+    static void check_required(json_internal::SchemaReader &reader,
+                               uint64_t found) {
+        using M = decltype(json_internal::member_type(Field::member));
+        if (!json_internal::is_optional<M>::value &&
+            !(found & (uint64_t{1} << I))) {
+            reader.error("missing key \"" + std::string{Field::name.view()} +
+                         "\"");
+        }
+    }
+};
+
+/// Parse json text into a type that has a schema_for specialization
+template <typename T>
+    requires json_internal::HasSchema<T>
+T parse_as(std::string_view input) {
+    return schema_for<T>::parse(input);
+}
+
+} // namespace json
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FAST_JSON_HAS_SSE2 1
+#endif
+
+// Helpers for scanning bytes 16 at a time. Every function has a scalar
+// fallback that is used at the end of the input, on platforms without SSE2
+// and in constant evaluation.
+
+namespace json {
+
+namespace json_internal {
+
+/// Find the first character in [begin, end) that is one of `Cs`, or return
+/// `end` if there is none
+template <char... Cs>
+constexpr const char *find_any(const char *begin, const char *end) {
+#ifdef FAST_JSON_HAS_SSE2
+    while (!std::is_constant_evaluated() && end - begin >= 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        auto matches = _mm_setzero_si128();
+        ((matches = _mm_or_si128(matches,
+                                 _mm_cmpeq_epi8(chunk, _mm_set1_epi8(Cs)))),
+         ...);
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+        if (mask) {
+            return begin + std::countr_zero(mask);
+        }
+        begin += 16;
+    }
+#endif
+    for (; begin != end; ++begin) {
+        if (((*begin == Cs) || ...)) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+/// Find the first quote, backslash or control character, which is where a
+/// string scan needs to stop in strict mode
+constexpr const char *find_string_special(const char *begin,
+                                          const char *end) {
+#ifdef FAST_JSON_HAS_SSE2
+    while (!std::is_constant_evaluated() && end - begin >= 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        auto control = _mm_set1_epi8(0x1f);
+        auto matches = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')),
+                         _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+            // Unsigned chunk <= 0x1f
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+        if (mask) {
+            return begin + std::countr_zero(mask);
+        }
+        begin += 16;
+    }
+#endif
+    for (; begin != end; ++begin) {
+        auto c = static_cast<unsigned char>(*begin);
+        if (c == '\"' || c == '\\' || c < 0x20) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+/// Find the first occurrence of `needle` in [begin, end), or return `end`.
+/// Positions where both the first and the last byte of the needle matches are
+/// found 16 at a time before the whole needle is compared
+inline const char *find_substring(const char *begin,
+                                  const char *end,
+                                  std::string_view needle) {
+    auto n = needle.size();
+    if (n == 0) {
+        return begin;
+    }
+    if (static_cast<size_t>(end - begin) < n) {
+        return end;
+    }
+    auto last = end - n + 1; // One after the last possible start
+#ifdef FAST_JSON_HAS_SSE2
+    auto first_byte = _mm_set1_epi8(needle.front());
+    auto last_byte = _mm_set1_epi8(needle.back());
+    while (last - begin >= 16) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        auto b =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin + n - 1));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(a, first_byte), _mm_cmpeq_epi8(b, last_byte))));
+        while (mask) {
+            auto candidate = begin + std::countr_zero(mask);
+            if (std::memcmp(candidate + 1, needle.data() + 1, n - 1) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+        begin += 16;
+    }
+#endif
+    for (; begin != last; ++begin) {
+        if (*begin == needle.front() &&
+            std::memcmp(begin + 1, needle.data() + 1, n - 1) == 0) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+constexpr bool is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/// Return the first character that is not json whitespace
+inline const char *skip_whitespace(const char *begin, const char *end) {
+    // Most of the time there is only a few spaces to skip
+    if (begin != end && !is_whitespace(*begin)) {
+        return begin;
+    }
+#ifdef FAST_JSON_HAS_SSE2
+    while (end - begin >= 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        auto spaces = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                         _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+        auto mask = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xffff;
+        if (mask) {
+            return begin + std::countr_zero(mask);
+        }
+        begin += 16;
+    }
+#endif
+    while (begin != end && is_whitespace(*begin)) {
+        ++begin;
+    }
+    return begin;
+}
+
+} // namespace json_internal
+
+} // namespace json
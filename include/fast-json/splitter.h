@@ -0,0 +1,169 @@
+#pragma once
+
+#include "simd.h"
+#include <stdexcept>
+#include <string_view>
+
+namespace json {
+
+enum class SplitMode {
+    /// Values after each other separated by whitespace, for example NDJSON
+    Values,
+
+    /// The elements of a top level array
+    ArrayElements,
+};
+
+/// Finds complete json values in text that arrives in pieces, without parsing
+/// them. The buffer passed to next() is owned by the caller, it should
+/// contain the same data each time with new data appended at the end. Data
+/// before consumed() can be removed by the caller, followed by a call to
+/// discard()
+class RecordSplitter {
+public:
+    static constexpr size_t npos = std::string_view::npos;
+
+    explicit RecordSplitter(SplitMode mode = SplitMode::Values)
+        : _level{mode == SplitMode::ArrayElements ? 1 : 0} {}
+
+    /// The next complete record in `buffer`, or a empty view if more data is
+    /// needed
+    std::string_view next(std::string_view buffer) {
+        while (_pos < buffer.size()) {
+            auto c = buffer[_pos];
+
+            if (_is_in_string) {
+                auto p = json_internal::find_any<'\"', '\\'>(
+                    buffer.data() + _pos, buffer.data() + buffer.size());
+                _pos = static_cast<size_t>(p - buffer.data());
+                if (_pos >= buffer.size()) {
+                    break;
+                }
+                if (*p == '\\') {
+                    if (_pos + 1 >= buffer.size()) {
+                        break; // Wait for the escaped character
+                    }
+                    _pos += 2;
+                    continue;
+                }
+                _is_in_string = false;
+                ++_pos;
+                if (_depth == _level) {
+                    return take(buffer, _pos);
+                }
+                continue;
+            }
+
+            if (_start == npos) {
+                if (json_internal::is_whitespace(c)) {
+                    ++_pos;
+                    continue;
+                }
+                if (_is_done) {
+                    return {}; // Content after the array is ignored
+                }
+                if (_level) {
+                    if (!_depth) {
+                        if (c != '[') {
+                            throw std::runtime_error{"expected array"};
+                        }
+                        _depth = 1;
+                        ++_pos;
+                        continue;
+                    }
+                    if (c == ',') {
+                        ++_pos;
+                        continue;
+                    }
+                    if (c == ']') {
+                        _is_done = true;
+                        _depth = 0;
+                        ++_pos;
+                        return {};
+                    }
+                }
+                _start = _pos;
+                if (c == '}' || c == ']') {
+                    // Let the parser report the unexpected character
+                    return take(buffer, ++_pos);
+                }
+                _is_scalar = c != '{' && c != '[' && c != '\"';
+            }
+
+            if (_is_scalar) {
+                if (json_internal::is_whitespace(c) || c == ',' || c == ']' ||
+                    c == '}') {
+                    return take(buffer, _pos);
+                }
+                ++_pos;
+                continue;
+            }
+
+            ++_pos;
+            switch (c) {
+            case '\"':
+                _is_in_string = true;
+                break;
+            case '{':
+            case '[':
+                ++_depth;
+                break;
+            case '}':
+            case ']':
+                if (--_depth == _level) {
+                    return take(buffer, _pos);
+                }
+                break;
+            }
+        }
+        return {};
+    }
+
+    /// Call at the end of the input. Returns the last record if it was not
+    /// terminated, for example a number without a trailing newline. A
+    /// incomplete container is returned as is so that the parser reports it
+    std::string_view finish(std::string_view buffer) {
+        if (_start == npos) {
+            return {};
+        }
+        return take(buffer, buffer.size());
+    }
+
+    /// Everything before this position in the buffer has been returned
+    size_t consumed() const {
+        return _start == npos ? _pos : _start;
+    }
+
+    /// The caller has removed `size` bytes from the start of the buffer.
+    /// `size` can be at most consumed()
+    void discard(size_t size) {
+        _pos -= size;
+        if (_start != npos) {
+            _start -= size;
+        }
+    }
+
+    /// True when the end of the array is found in SplitMode::ArrayElements
+    bool is_done() const {
+        return _is_done;
+    }
+
+private:
+    std::string_view take(std::string_view buffer, size_t end) {
+        auto record = buffer.substr(_start, end - _start);
+        _start = npos;
+        _pos = end;
+        _is_scalar = false;
+        return record;
+    }
+
+    int _level = 0; // The depth where records are found
+    int _depth = 0;
+    size_t _pos = 0;
+    size_t _start = npos;
+    bool _is_in_string = false;
+    bool _is_scalar = false;
+    bool _is_done = false;
+};
+
+} // namespace json
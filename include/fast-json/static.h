@@ -0,0 +1,431 @@
+#pragma once
+
+#include "fixedstring.h"
+#include "json.h"
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace json {
+
+namespace json_internal {
+
+/// A node in a StaticDocument. The nodes are stored in document order, and
+/// `end` is the index after the last node in the subtree, so that siblings
+/// can be found without pointers
+struct StaticNode {
+    Token value;
+    uint32_t size = 0;
+    uint32_t end = 0;
+};
+
+/// The number of nodes needed for `input`
+constexpr size_t count_static_nodes(std::string_view input) {
+    size_t count = 0;
+    auto tokenizer = Tokenizer{input, ParseOptions{.strict = true}};
+    for (auto &token : tokenizer) {
+        switch (token.type) {
+        case TokenType::END_OBJECT:
+        case TokenType::END_ARRAY:
+        case TokenType::COLON:
+        case TokenType::COMMA:
+            break;
+        default:
+            ++count;
+        }
+    }
+    return count;
+}
+
+/// Convert a number without std::from_chars, that can not be used in
+/// constant evaluation before C++23
+template <typename T>
+constexpr T parse_number(std::string_view text) {
+    size_t i = 0;
+    bool is_negative = text[0] == '-';
+    if (is_negative) {
+        ++i;
+    }
+    if constexpr (std::is_integral_v<T>) {
+        T value = 0;
+        for (; i < text.size(); ++i) {
+            if (!is_digit(text[i])) {
+                throw std::invalid_argument{"expected integer"};
+            }
+            auto digit = static_cast<T>(text[i] - '0');
+            if (value > (std::numeric_limits<T>::max() - digit) / 10) {
+                throw std::out_of_range{"number out of range"};
+            }
+            value = value * 10 + digit;
+        }
+        if (is_negative) {
+            if constexpr (std::is_unsigned_v<T>) {
+                if (value) {
+                    throw std::out_of_range{"number out of range"};
+                }
+            }
+            return static_cast<T>(-value);
+        }
+        return value;
+    }
+    else {
+        // Not always correctly rounded, but used for compile time only
+        double mantissa = 0;
+        int exponent = 0;
+        for (; i < text.size() && is_digit(text[i]); ++i) {
+            mantissa = mantissa * 10 + (text[i] - '0');
+        }
+        if (i < text.size() && text[i] == '.') {
+            for (++i; i < text.size() && is_digit(text[i]); ++i) {
+                mantissa = mantissa * 10 + (text[i] - '0');
+                --exponent;
+            }
+        }
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+            ++i;
+            bool is_negative_exponent = text[i] == '-';
+            if (text[i] == '-' || text[i] == '+') {
+                ++i;
+            }
+            int e = 0;
+            for (; i < text.size(); ++i) {
+                e = e * 10 + (text[i] - '0');
+            }
+            exponent += is_negative_exponent ? -e : e;
+        }
+        for (; exponent > 0; --exponent) {
+            mantissa *= 10;
+        }
+        for (; exponent < 0; ++exponent) {
+            mantissa /= 10;
+        }
+        return static_cast<T>(is_negative ? -mantissa : mantissa);
+    }
+}
+
+} // namespace json_internal
+
+/// A value in a StaticDocument. The same interface as JsonNode, but every
+/// function can be used in constant expressions
+class StaticValue {
+public:
+    constexpr StaticValue(const json_internal::StaticNode *nodes,
+                          uint32_t index)
+        : _nodes{nodes}
+        , _index{index} {}
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = StaticValue;
+        using difference_type = std::ptrdiff_t;
+
+        constexpr const_iterator() = default;
+
+        constexpr const_iterator(const json_internal::StaticNode *nodes,
+                                 uint32_t index)
+            : _nodes{nodes}
+            , _index{index} {}
+
+        constexpr StaticValue operator*() const {
+            return {_nodes, _index};
+        }
+
+        constexpr const_iterator &operator++() {
+            _index = _nodes[_index].end;
+            return *this;
+        }
+
+        constexpr const_iterator operator++(int) {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        constexpr bool operator==(const const_iterator &) const = default;
+
+    private:
+        const json_internal::StaticNode *_nodes = nullptr;
+        uint32_t _index = 0;
+    };
+
+    constexpr const Token &value() const {
+        return node().value;
+    }
+
+    constexpr TokenType type() const {
+        return node().value.type;
+    }
+
+    constexpr size_t size() const {
+        return node().size;
+    }
+
+    constexpr bool empty() const {
+        return !size();
+    }
+
+    constexpr const_iterator begin() const {
+        return {_nodes, _index + 1};
+    }
+
+    constexpr const_iterator end() const {
+        return {_nodes, node().end};
+    }
+
+    /// The first child, or for a key its value
+    constexpr StaticValue children() const {
+        if (!size()) {
+            throw std::out_of_range{"no children in node"};
+        }
+        return {_nodes, _index + 1};
+    }
+
+    constexpr std::optional<StaticValue> find(std::string_view name) const {
+        validate(TokenType::BEGIN_OBJECT, "object");
+        for (auto key : *this) {
+            if (key.value().value == name) {
+                return key.children();
+            }
+        }
+        return std::nullopt;
+    }
+
+    constexpr bool contains(std::string_view name) const {
+        return find(name).has_value();
+    }
+
+    constexpr StaticValue at(std::string_view name) const {
+        if (auto value = find(name)) {
+            return *value;
+        }
+        throw std::out_of_range{"element " + std::string{name} +
+                                " not found"};
+    }
+
+    constexpr StaticValue operator[](std::string_view name) const {
+        return at(name);
+    }
+
+    constexpr StaticValue at(size_t index) const {
+        validate(TokenType::BEGIN_ARRAY, "array");
+        if (index >= size()) {
+            throw std::out_of_range{"index " + std::to_string(index) +
+                                    " out of range"};
+        }
+        auto it = begin();
+        for (size_t i = 0; i < index; ++i) {
+            ++it;
+        }
+        return *it;
+    }
+
+    constexpr StaticValue operator[](size_t index) const {
+        return at(index);
+    }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    constexpr T number() const {
+        validate(TokenType::NUMBER, "number");
+        auto text = value().value;
+        if (std::is_constant_evaluated()) {
+            return json_internal::parse_number<T>(text);
+        }
+        auto result = T{};
+        auto [ptr, ec] =
+            std::from_chars(text.data(), text.data() + text.size(), result);
+        if (ec != std::errc{} || ptr != text.data() + text.size()) {
+            throw std::invalid_argument{"invalid number"};
+        }
+        return result;
+    }
+
+    constexpr bool boolean() const {
+        validate(TokenType::BOOLEAN, "boolean");
+        return value().value == "true";
+    }
+
+    constexpr bool is_null() const {
+        return type() == TokenType::NULL_VALUE;
+    }
+
+    /// The text of a string with the escapes left in place
+    constexpr std::string_view raw() const {
+        if (type() != TokenType::STRING && type() != TokenType::KEY) {
+            throw std::invalid_argument{
+                "json entity is not of type 'string'"};
+        }
+        return value().value;
+    }
+
+    /// The content of a string. Strings with escape sequences can not be
+    /// returned as a view, use raw() or a JsonNode for them
+    constexpr std::string_view str() const {
+        auto text = raw();
+        if (text.find('\\') != std::string_view::npos) {
+            throw std::invalid_argument{"string contains escape sequences"};
+        }
+        return text;
+    }
+
+private:
+    constexpr const json_internal::StaticNode &node() const {
+        return _nodes[_index];
+    }
+
+    constexpr void validate(TokenType type, const char *name) const {
+        if (this->type() != type) {
+            throw std::invalid_argument{
+                std::string{"json entity is not of type '"} + name + "'"};
+        }
+    }
+
+    const json_internal::StaticNode *_nodes;
+    uint32_t _index;
+};
+
+/// A document with room for `Capacity` nodes that can be parsed in a
+/// constant expression. The text is checked in strict mode, so malformed
+/// json embedded in the program is a compile error:
+///
+///   constexpr auto flags = json::StaticDocument<8>{R"({"beta": true})"};
+///   static_assert(flags["beta"].boolean());
+///
+/// The nodes refers to the text, which should be a string literal or have
+/// static storage duration. See also static_json()
+template <size_t Capacity>
+class StaticDocument {
+public:
+    constexpr explicit StaticDocument(std::string_view input) {
+        using namespace json_internal;
+        auto tokenizer = Tokenizer{input, ParseOptions{.strict = true}};
+        auto validator = GrammarValidator{};
+        auto open = std::vector<uint32_t>{};
+
+        auto it = tokenizer.begin();
+        for (; it != tokenizer.end(); ++it) {
+            auto &token = *it;
+            if (auto error = validator.feed(token)) {
+                it.throw_error(error, token);
+            }
+            switch (token.type) {
+            case TokenType::COLON:
+            case TokenType::COMMA:
+                continue;
+            case TokenType::END_OBJECT:
+            case TokenType::END_ARRAY: {
+                auto index = open.back();
+                open.pop_back();
+                close_value(index, open);
+                break;
+            }
+            default: {
+                // Strings directly in objects are keys, that has the next
+                // value as child
+                bool is_key =
+                    !open.empty() &&
+                    _nodes[open.back()].value.type == TokenType::BEGIN_OBJECT;
+                if (!open.empty()) {
+                    auto &parent = _nodes[open.back()];
+                    parent.size =
+                        parent.value.type == TokenType::KEY ? 1
+                                                            : parent.size + 1;
+                }
+                if (_size == Capacity) {
+                    throw std::length_error{"too many nodes for document"};
+                }
+                auto index = static_cast<uint32_t>(_size++);
+                _nodes[index].value =
+                    is_key ? Token{TokenType::KEY, token.value} : token;
+                if (is_key || token.type == TokenType::BEGIN_OBJECT ||
+                    token.type == TokenType::BEGIN_ARRAY) {
+                    open.push_back(index);
+                }
+                else {
+                    close_value(index, open);
+                }
+            }
+            }
+        }
+        if (auto error = validator.finish()) {
+            it.throw_error(error, input.size());
+        }
+    }
+
+    constexpr StaticValue root() const {
+        if (!_size) {
+            throw std::out_of_range{"document is empty"};
+        }
+        return {_nodes.data(), 0};
+    }
+
+    constexpr StaticValue operator*() const {
+        return root();
+    }
+
+    constexpr StaticValue operator[](std::string_view name) const {
+        return root().at(name);
+    }
+
+    constexpr StaticValue operator[](size_t index) const {
+        return root().at(index);
+    }
+
+    /// The number of nodes that is used
+    constexpr size_t size() const {
+        return _size;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    constexpr void close(uint32_t index) {
+        _nodes[index].end = static_cast<uint32_t>(_size);
+    }
+
+    /// Close a value and the key that it belongs to
+    constexpr void close_value(uint32_t index, std::vector<uint32_t> &open) {
+        close(index);
+        if (!open.empty() && _nodes[open.back()].value.type == TokenType::KEY) {
+            close(open.back());
+            open.pop_back();
+        }
+    }
+
+    std::array<json_internal::StaticNode, Capacity> _nodes = {};
+    size_t _size = 0;
+};
+
+namespace json_internal {
+
+/// Gives the text a static storage duration so that the document can refer
+/// to it
+template <fixed_string Text>
+struct StaticText {
+    static constexpr auto value = Text;
+};
+
+} // namespace json_internal
+
+/// Parse a string literal at compile time into a StaticDocument that is just
+/// large enough:
+///
+///   constexpr auto table = json::static_json<R"({"a": [1, 2]})">();
+///   static_assert(table["a"][1].number<int>() == 2);
+template <fixed_string Text>
+consteval auto static_json() {
+    constexpr auto input = json_internal::StaticText<Text>::value.view();
+    constexpr auto num_nodes = json_internal::count_static_nodes(input);
+    return StaticDocument<num_nodes>{input};
+}
+
+} // namespace json
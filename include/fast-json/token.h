@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdexcept>
+#include <string>
 #include <string_view>
 
 namespace json {
@@ -27,8 +29,48 @@ struct Token {
 struct TokenLocation {
     size_t line_number;
     size_t column_number;
+
+    bool operator==(const TokenLocation &) const = default;
+};
+
+/// Thrown when the input could not be parsed. Contains the position of the
+/// error in the input
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string &message,
+               size_t offset,
+               TokenLocation location)
+        : std::runtime_error{message + " at line " +
+                             std::to_string(location.line_number) +
+                             ", column " +
+                             std::to_string(location.column_number)}
+        , _offset{offset}
+        , _location{location} {}
+
+    /// Position in bytes from the start of the input
+    size_t offset() const {
+        return _offset;
+    }
+
+    size_t line() const {
+        return _location.line_number;
+    }
+
+    size_t column() const {
+        return _location.column_number;
+    }
+
+    const TokenLocation &location() const {
+        return _location;
+    }
+
+private:
+    size_t _offset = 0;
+    TokenLocation _location;
 };
 
+/// Find the line and column of a token by counting lines from the start of
+/// the file. Use LineIndex (lineindex.h) when looking up many tokens
 inline TokenLocation get_token_position(const Token &token,
                                         std::string_view whole_file) {
     size_t line_number = 1;
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "json.h"
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace json {
+
+/// What JsonTransform does with a member of a object
+struct MemberRule {
+    /// Remove the member with its value
+    bool drop = false;
+
+    /// A new name of the member, not escaped
+    std::optional<std::string> name;
+
+    /// Called with the source text of the value, returns the json text that
+    /// replaces it
+    std::function<std::string(std::string_view value)> replace;
+};
+
+/// Rewrites json text by dropping, renaming or replacing the values of
+/// members, without building a tree. The text is tokenized and copied to the
+/// output in as few pieces as possible, so everything that the rules do not
+/// change is kept as is, including whitespace. Apart from the input and the
+/// output, the memory used only depends on the depth of the document.
+///
+/// Rules are looked up by the JSON Pointer of the member in the input, where
+/// "*" stands for any element of a array, for example "/items/*/price". The
+/// values of dropped or replaced members are not looked at further. The
+/// grammar is always checked, but the output is written while reading, so a
+/// ParseError can be thrown after part of the output is written
+class JsonTransform {
+public:
+    using MemberCallback =
+        std::function<std::optional<MemberRule>(std::string_view path)>;
+
+    JsonTransform &drop(const std::string &path) {
+        _rules[path].drop = true;
+        return *this;
+    }
+
+    JsonTransform &rename(const std::string &path, std::string name) {
+        _rules[path].name = std::move(name);
+        return *this;
+    }
+
+    /// Replace the value with json text
+    JsonTransform &replace(const std::string &path, std::string value) {
+        _rules[path].replace = [value = std::move(value)](std::string_view) {
+            return value;
+        };
+        return *this;
+    }
+
+    JsonTransform &replace(
+        const std::string &path,
+        std::function<std::string(std::string_view value)> f) {
+        _rules[path].replace = std::move(f);
+        return *this;
+    }
+
+    /// Called for members that have no rule by path, for example to redact
+    /// a key at any depth
+    JsonTransform &on_member(MemberCallback f) {
+        _on_member = std::move(f);
+        return *this;
+    }
+
+    void apply(std::string_view input,
+               std::string &out,
+               const ParseOptions &options = {}) const {
+        auto write = [&out](std::string_view str) { out += str; };
+        transform(input, write, options);
+    }
+
+    void apply(std::string_view input,
+               std::ostream &os,
+               const ParseOptions &options = {}) const {
+        auto write = [&os](std::string_view str) {
+            os.write(str.data(), static_cast<std::streamsize>(str.size()));
+        };
+        transform(input, write, options);
+    }
+
+    std::string apply(std::string_view input,
+                      const ParseOptions &options = {}) const {
+        auto out = std::string{};
+        apply(input, out, options);
+        return out;
+    }
+
+private:
+    /// An open object or array
+    struct Frame {
+        bool is_object = false;
+
+        /// A member before the current one is written, kept or replaced
+        bool has_written = false;
+
+        /// The first member was dropped, so the comma after it is too
+        bool should_skip_comma = false;
+
+        /// The comma before the current member
+        size_t comma = std::string_view::npos;
+
+        size_t path_length = 0;
+    };
+
+    /// Write the output in pieces with `write(std::string_view)`
+    template <typename Write>
+    void transform(std::string_view input,
+                   Write &write,
+                   const ParseOptions &options) const {
+        constexpr auto npos = std::string_view::npos;
+
+        auto begin_of = [&](const Token &token) {
+            auto pos = static_cast<size_t>(token.value.data() - input.data());
+            return token.type == TokenType::STRING ? pos - 1 : pos;
+        };
+        auto end_of = [&](const Token &token) {
+            auto pos = static_cast<size_t>(token.value.data() - input.data()) +
+                       token.value.size();
+            return token.type == TokenType::STRING ? pos + 1 : pos;
+        };
+
+        size_t copied = 0;
+        auto copy_to = [&](size_t pos) {
+            write(input.substr(copied, pos - copied));
+            copied = pos;
+        };
+
+        auto validator = json_internal::GrammarValidator{};
+        auto frames = std::vector<Frame>{};
+        auto path = std::string{};
+        auto is_key_next = false;
+        auto should_skip_space = false;
+
+        // The member that is dropped or replaced
+        auto dynamic_rule = std::optional<MemberRule>{};
+        const MemberRule *rule = nullptr;
+        size_t member_begin = 0;
+        size_t value_begin = npos;
+        int skip_depth = 0;
+
+        auto finish_member = [&](size_t value_end) {
+            auto &frame = frames.back();
+            if (rule->drop) {
+                if (frame.has_written) {
+                    copy_to(frame.comma);
+                }
+                else {
+                    copy_to(member_begin);
+                    frame.should_skip_comma = true;
+                }
+            }
+            else {
+                copy_to(value_begin);
+                write(rule->replace(
+                    input.substr(value_begin, value_end - value_begin)));
+                frame.has_written = true;
+            }
+            copied = value_end;
+            rule = nullptr;
+            value_begin = npos;
+        };
+
+        auto tokenizer = json_internal::Tokenizer{input, options};
+        auto it = tokenizer.begin();
+        for (; it != tokenizer.end(); ++it) {
+            auto &token = *it;
+            if (auto error = validator.feed(token)) {
+                it.throw_error(error, token);
+            }
+            if (should_skip_space) {
+                copied = begin_of(token);
+                should_skip_space = false;
+            }
+
+            if (rule) {
+                // Find the end of the value that is dropped or replaced
+                if (token.type == TokenType::COLON) {
+                    continue;
+                }
+                if (value_begin == npos) {
+                    value_begin = begin_of(token);
+                }
+                if (token.type == TokenType::BEGIN_OBJECT ||
+                    token.type == TokenType::BEGIN_ARRAY) {
+                    ++skip_depth;
+                }
+                else if (token.type == TokenType::END_OBJECT ||
+                         token.type == TokenType::END_ARRAY) {
+                    --skip_depth;
+                }
+                if (!skip_depth) {
+                    finish_member(end_of(token));
+                }
+                continue;
+            }
+
+            switch (token.type) {
+            case TokenType::BEGIN_OBJECT:
+            case TokenType::BEGIN_ARRAY: {
+                auto is_object = token.type == TokenType::BEGIN_OBJECT;
+                if (!is_object) {
+                    path += "/*";
+                }
+                auto &frame = frames.emplace_back();
+                frame.is_object = is_object;
+                frame.path_length = path.size();
+                is_key_next = is_object;
+                break;
+            }
+            case TokenType::END_OBJECT:
+            case TokenType::END_ARRAY:
+                frames.pop_back();
+                if (!frames.empty()) {
+                    path.resize(frames.back().path_length);
+                }
+                is_key_next = false;
+                break;
+            case TokenType::COMMA: {
+                auto &frame = frames.back();
+                if (frame.should_skip_comma) {
+                    // Up to the next member
+                    frame.should_skip_comma = false;
+                    copied = end_of(token);
+                    should_skip_space = true;
+                }
+                else {
+                    frame.comma = begin_of(token);
+                }
+                is_key_next = frame.is_object;
+                break;
+            }
+            case TokenType::STRING:
+                if (is_key_next) {
+                    is_key_next = false;
+                    path.resize(frames.back().path_length);
+                    json_internal::append_pointer_token(path, token.value);
+                    auto found = find_rule(path, dynamic_rule);
+                    if (found && found->name && !found->drop) {
+                        copy_to(begin_of(token));
+                        auto key = std::string{"\""};
+                        json_internal::escape_to(key, *found->name);
+                        key += "\"";
+                        write(key);
+                        copied = end_of(token);
+                    }
+                    if (found && (found->drop || found->replace)) {
+                        rule = found;
+                        member_begin = begin_of(token);
+                    }
+                    else {
+                        frames.back().has_written = true;
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        if (auto error = validator.finish()) {
+            it.throw_error(error, input.size());
+        }
+        copy_to(input.size());
+    }
+
+    const MemberRule *find_rule(std::string_view path,
+                                std::optional<MemberRule> &dynamic) const {
+        if (!_rules.empty()) {
+            if (auto it = _rules.find(std::string{path}); it != _rules.end()) {
+                return &it->second;
+            }
+        }
+        if (_on_member) {
+            dynamic = _on_member(path);
+            if (dynamic) {
+                return &*dynamic;
+            }
+        }
+        return nullptr;
+    }
+
+    std::unordered_map<std::string, MemberRule> _rules;
+    MemberCallback _on_member;
+};
+
+} // namespace json
@@ -0,0 +1,313 @@
+#pragma once
+
+#include "simd.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define FAST_JSON_HAS_SSSE3 1
+#endif
+
+namespace json {
+
+namespace json_internal {
+
+/// Validate one character at a time. Returns the position of the first
+/// invalid byte or `end` if everything is valid
+inline const unsigned char *find_invalid_utf8_scalar(
+    const unsigned char *p, const unsigned char *end) {
+    while (p < end) {
+        auto c = *p;
+        if (c < 0x80) {
+            ++p;
+            continue;
+        }
+
+        size_t num_continuations = 0;
+        uint32_t code_point = 0;
+        uint32_t min = 0;
+        if ((c & 0xe0) == 0xc0) {
+            num_continuations = 1;
+            code_point = c & 0x1f;
+            min = 0x80;
+        }
+        else if ((c & 0xf0) == 0xe0) {
+            num_continuations = 2;
+            code_point = c & 0x0f;
+            min = 0x800;
+        }
+        else if ((c & 0xf8) == 0xf0) {
+            num_continuations = 3;
+            code_point = c & 0x07;
+            min = 0x10000;
+        }
+        else {
+            return p;
+        }
+
+        if (static_cast<size_t>(end - p) <= num_continuations) {
+            return p;
+        }
+        for (size_t i = 1; i <= num_continuations; ++i) {
+            auto b = p[i];
+            if ((b & 0xc0) != 0x80) {
+                return p;
+            }
+            code_point = (code_point << 6) | (b & 0x3f);
+        }
+        if (code_point < min || code_point > 0x10ffff ||
+            (code_point >= 0xd800 && code_point <= 0xdfff)) {
+            return p;
+        }
+        p += num_continuations + 1;
+    }
+    return end;
+}
+
+#ifdef FAST_JSON_HAS_SSSE3
+
+/// Vectorized validation with the lookup algorithm by Keiser and Lemire
+/// ("Validating UTF-8 In Less Than One Instruction Per Byte"). Each block of
+/// 16 bytes is checked with three table lookups on the high and low nibbles
+/// of the previous byte and the high nibble of the current byte.
+class Utf8Checker {
+public:
+    void feed(__m128i input) {
+        if (!_mm_movemask_epi8(input)) {
+            // Only ascii, but the previous block may have ended in the middle
+            // of a character
+            _error = _mm_or_si128(_error, _previous_incomplete);
+            _previous_incomplete = _mm_setzero_si128();
+        }
+        else {
+            check_block(input);
+            _previous_incomplete = is_incomplete(input);
+        }
+        _previous = input;
+    }
+
+    bool is_valid() {
+        auto error = _mm_or_si128(_error, _previous_incomplete);
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) ==
+               0xffff;
+    }
+
+private:
+    static constexpr uint8_t too_short = 1 << 0;
+    static constexpr uint8_t too_long = 1 << 1;
+    static constexpr uint8_t overlong_3 = 1 << 2;
+    static constexpr uint8_t too_large = 1 << 3;
+    static constexpr uint8_t surrogate = 1 << 4;
+    static constexpr uint8_t overlong_2 = 1 << 5;
+    static constexpr uint8_t too_large_1000 = 1 << 6;
+    static constexpr uint8_t overlong_4 = 1 << 6;
+    static constexpr uint8_t two_continuations = 1 << 7;
+    static constexpr uint8_t carry = too_short | too_long | two_continuations;
+
+    static __m128i table(uint8_t a0,
+                         uint8_t a1,
+                         uint8_t a2,
+                         uint8_t a3,
+                         uint8_t a4,
+                         uint8_t a5,
+                         uint8_t a6,
+                         uint8_t a7,
+                         uint8_t a8,
+                         uint8_t a9,
+                         uint8_t a10,
+                         uint8_t a11,
+                         uint8_t a12,
+                         uint8_t a13,
+                         uint8_t a14,
+                         uint8_t a15) {
+        return _mm_setr_epi8(static_cast<char>(a0),
+                             static_cast<char>(a1),
+                             static_cast<char>(a2),
+                             static_cast<char>(a3),
+                             static_cast<char>(a4),
+                             static_cast<char>(a5),
+                             static_cast<char>(a6),
+                             static_cast<char>(a7),
+                             static_cast<char>(a8),
+                             static_cast<char>(a9),
+                             static_cast<char>(a10),
+                             static_cast<char>(a11),
+                             static_cast<char>(a12),
+                             static_cast<char>(a13),
+                             static_cast<char>(a14),
+                             static_cast<char>(a15));
+    }
+
+    static __m128i high_nibbles(__m128i v) {
+        return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+    }
+
+    void check_block(__m128i input) {
+        auto previous1 = _mm_alignr_epi8(input, _previous, 15);
+
+        auto byte_1_high = _mm_shuffle_epi8(
+            table(too_long,
+                  too_long,
+                  too_long,
+                  too_long,
+                  too_long,
+                  too_long,
+                  too_long,
+                  too_long,
+                  two_continuations,
+                  two_continuations,
+                  two_continuations,
+                  two_continuations,
+                  too_short | overlong_2,
+                  too_short,
+                  too_short | overlong_3 | surrogate,
+                  too_short | too_large | too_large_1000 | overlong_4),
+            high_nibbles(previous1));
+
+        constexpr uint8_t large = carry | too_large | too_large_1000;
+        auto byte_1_low = _mm_shuffle_epi8(
+            table(carry | overlong_3 | overlong_2 | overlong_4,
+                  carry | overlong_2,
+                  carry,
+                  carry,
+                  carry | too_large,
+                  large,
+                  large,
+                  large,
+                  large,
+                  large,
+                  large,
+                  large,
+                  large,
+                  large | surrogate,
+                  large,
+                  large),
+            _mm_and_si128(previous1, _mm_set1_epi8(0x0f)));
+
+        constexpr uint8_t continuation = too_long | overlong_2 |
+                                         two_continuations;
+        auto byte_2_high = _mm_shuffle_epi8(
+            table(too_short,
+                  too_short,
+                  too_short,
+                  too_short,
+                  too_short,
+                  too_short,
+                  too_short,
+                  too_short,
+                  continuation | overlong_3 | too_large_1000 | overlong_4,
+                  continuation | overlong_3 | too_large,
+                  continuation | surrogate | too_large,
+                  continuation | surrogate | too_large,
+                  too_short,
+                  too_short,
+                  too_short,
+                  too_short),
+            high_nibbles(input));
+
+        auto special_cases =
+            _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+        // Third and fourth bytes of a character must be continuations
+        auto previous2 = _mm_alignr_epi8(input, _previous, 14);
+        auto previous3 = _mm_alignr_epi8(input, _previous, 13);
+        auto is_third_byte =
+            _mm_subs_epu8(previous2, _mm_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+        auto is_fourth_byte =
+            _mm_subs_epu8(previous3, _mm_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+        auto must_be_continuation =
+            _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte),
+                          _mm_set1_epi8(static_cast<char>(0x80)));
+
+        _error = _mm_or_si128(_error,
+                              _mm_xor_si128(must_be_continuation, special_cases));
+    }
+
+    /// Nonzero if the block ends in the middle of a character
+    static __m128i is_incomplete(__m128i input) {
+        auto max = _mm_setr_epi8(-1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 -1,
+                                 static_cast<char>(0xf0 - 1),
+                                 static_cast<char>(0xe0 - 1),
+                                 static_cast<char>(0xc0 - 1));
+        return _mm_subs_epu8(input, max);
+    }
+
+    __m128i _error = _mm_setzero_si128();
+    __m128i _previous = _mm_setzero_si128();
+    __m128i _previous_incomplete = _mm_setzero_si128();
+};
+
+#endif
+
+} // namespace json_internal
+
+/// Check that `str` is valid UTF-8: no overlong encodings, surrogates, code
+/// points above U+10FFFF or truncated characters
+inline bool is_valid_utf8(std::string_view str) {
+    auto p = reinterpret_cast<const unsigned char *>(str.data());
+    auto end = p + str.size();
+
+#ifdef FAST_JSON_HAS_SSSE3
+    auto checker = json_internal::Utf8Checker{};
+    for (; end - p >= 16; p += 16) {
+        checker.feed(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    }
+    if (p != end) {
+        // Pad the last block with zeros, which counts as ascii
+        unsigned char last[16] = {};
+        std::memcpy(last, p, static_cast<size_t>(end - p));
+        checker.feed(_mm_loadu_si128(reinterpret_cast<const __m128i *>(last)));
+    }
+    return checker.is_valid();
+#else
+#ifdef FAST_JSON_HAS_SSE2
+    // Skip ascii 16 bytes at a time and only validate around other bytes
+    while (end - p >= 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(chunk));
+        if (!mask) {
+            p += 16;
+            continue;
+        }
+        p += std::countr_zero(mask);
+        // Validate to the end of the non ascii sequence
+        auto q = p;
+        while (q < end && *q >= 0x80) {
+            ++q;
+        }
+        // Characters only consists of bytes >= 0x80, so a valid sequence
+        // only contains complete characters
+        if (json_internal::find_invalid_utf8_scalar(p, q) != q) {
+            return false;
+        }
+        p = q;
+    }
+#endif
+    return json_internal::find_invalid_utf8_scalar(p, end) == end;
+#endif
+}
+
+/// Throws std::runtime_error if `str` is not valid UTF-8
+inline void validate_utf8(std::string_view str) {
+    if (!is_valid_utf8(str)) {
+        throw std::runtime_error{"Invalid UTF-8"};
+    }
+}
+
+} // namespace json
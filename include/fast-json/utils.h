@@ -3,22 +3,60 @@
 #include <filesystem>
 #include <fstream>
 #include <istream>
+#include <memory_resource>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 
 namespace json {
 
-inline std::string read_file_content(const std::filesystem::path &filename) {
-    std::ifstream input_file(filename);
-    if (input_file.is_open()) {
-        std::stringstream buffer;
-        buffer << input_file.rdbuf();
-        return buffer.str();
-    }
-    else {
+namespace json_internal {
+
+/// Read the whole file into `buffer`, with a single allocation if the size
+/// of the file is known
+template <typename String>
+void read_file_into(const std::filesystem::path &filename, String &buffer) {
+    std::ifstream input_file(filename, std::ios::binary);
+    if (!input_file.is_open()) {
         throw std::runtime_error{"Failed to open " + filename.string()};
-        return "";
     }
+    buffer.clear();
+    input_file.seekg(0, std::ios::end);
+    auto size = input_file.tellg();
+    input_file.seekg(0, std::ios::beg);
+    if (size > 0) {
+        buffer.resize(static_cast<size_t>(size));
+        input_file.read(buffer.data(), size);
+        buffer.resize(static_cast<size_t>(input_file.gcount()));
+        return;
+    }
+
+    // Pipes and files in /proc have no size, so they are read as a stream
+    input_file.clear();
+    char chunk[16384];
+    while (input_file.read(chunk, sizeof(chunk)) || input_file.gcount()) {
+        buffer.append(chunk, static_cast<size_t>(input_file.gcount()));
+    }
+    if (input_file.bad()) {
+        throw std::runtime_error{"Failed to read " + filename.string()};
+    }
+}
+
+} // namespace json_internal
+
+inline std::string read_file_content(const std::filesystem::path &filename) {
+    auto buffer = std::string{};
+    json_internal::read_file_into(filename, buffer);
+    return buffer;
+}
+
+/// Read a file into memory taken from `resource`
+inline std::pmr::string read_file_content(
+    const std::filesystem::path &filename,
+    std::pmr::memory_resource *resource) {
+    auto buffer = std::pmr::string{resource};
+    json_internal::read_file_into(filename, buffer);
+    return buffer;
 }
 
 inline std::string read_stream_content(std::istream &stream) {
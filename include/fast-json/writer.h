@@ -0,0 +1,95 @@
+#pragma once
+
+#include "jsonnode.h"
+#include "mutabledocument.h"
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace json {
+
+namespace json_internal {
+
+/// Write `node` by copying the source text of every subtree that is not
+/// modified. Modified objects and arrays are written without whitespace
+template <typename Write, typename IsModified>
+void write_source(const JsonNode &node,
+                  Write &write,
+                  const IsModified &is_modified) {
+    if (!is_modified(node)) {
+        write(node.source());
+        return;
+    }
+
+    auto type = node.value().type;
+    if (type == TokenType::BEGIN_OBJECT) {
+        write("{");
+        bool first = true;
+        for (auto &key : node) {
+            if (!first) {
+                write(",");
+            }
+            first = false;
+            write("\"");
+            write(key.value().value);
+            write("\":");
+            write_source(*key.children(), write, is_modified);
+        }
+        write("}");
+    }
+    else if (type == TokenType::BEGIN_ARRAY) {
+        write("[");
+        bool first = true;
+        for (auto &child : node) {
+            if (!first) {
+                write(",");
+            }
+            first = false;
+            write_source(child, write, is_modified);
+        }
+        write("]");
+    }
+    else {
+        write(node.source());
+    }
+}
+
+} // namespace json_internal
+
+/// Write a parsed value by copying its source text
+inline void write_json(const JsonNode &node, std::string &out) {
+    out += node.source();
+}
+
+inline void write_json(const JsonNode &node, std::ostream &os) {
+    auto source = node.source();
+    os.write(source.data(), static_cast<std::streamsize>(source.size()));
+}
+
+/// Write a document where only changed parts is formatted. Everything that
+/// was not touched is copied from the source text as is, including whitespace
+inline void write_json(const MutableDocument &doc, std::string &out) {
+    auto write = [&out](std::string_view str) { out += str; };
+    json_internal::write_source(
+        *doc, write, [&doc](const JsonNode &node) {
+            return doc.is_modified(node);
+        });
+}
+
+inline void write_json(const MutableDocument &doc, std::ostream &os) {
+    auto write = [&os](std::string_view str) {
+        os.write(str.data(), static_cast<std::streamsize>(str.size()));
+    };
+    json_internal::write_source(
+        *doc, write, [&doc](const JsonNode &node) {
+            return doc.is_modified(node);
+        });
+}
+
+inline std::string to_json_string(const MutableDocument &doc) {
+    auto out = std::string{};
+    write_json(doc, out);
+    return out;
+}
+
+} // namespace json
@@ -0,0 +1,92 @@
+// Reformat json files without parsing them into nodes
+//
+// Usage: fast-json-fmt [--minify | --indent N] [input [output]]
+// Input and output defaults to stdin and stdout, "-" can also be used
+
+#include "fast-json/format.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+void print_usage() {
+    std::cerr << "usage: fast-json-fmt [--minify | --indent N] [input [output]]\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    int indent = 2;
+    auto files = std::vector<std::string_view>{};
+
+    for (int i = 1; i < argc; ++i) {
+        auto arg = std::string_view{argv[i]};
+        if (arg == "--minify" || arg == "-m") {
+            indent = -1;
+        }
+        else if (arg == "--indent" || arg == "-i") {
+            if (++i >= argc) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+            indent = std::atoi(argv[i]);
+        }
+        else if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return EXIT_SUCCESS;
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.size() > 2) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    auto input_file = std::ifstream{};
+    auto output_file = std::ofstream{};
+    std::istream *in = &std::cin;
+    std::ostream *out = &std::cout;
+
+    if (files.size() > 0 && files.at(0) != "-") {
+        input_file.open(std::string{files.at(0)}, std::ios::binary);
+        if (!input_file) {
+            std::cerr << "could not open " << files.at(0) << "\n";
+            return EXIT_FAILURE;
+        }
+        in = &input_file;
+    }
+
+    if (files.size() > 1 && files.at(1) != "-") {
+        output_file.open(std::string{files.at(1)}, std::ios::binary);
+        if (!output_file) {
+            std::cerr << "could not open " << files.at(1) << "\n";
+            return EXIT_FAILURE;
+        }
+        out = &output_file;
+    }
+
+    try {
+        if (indent < 0) {
+            json::minify(*in, *out);
+        }
+        else {
+            json::prettify(*in, *out, indent);
+        }
+        *out << "\n";
+    }
+    catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
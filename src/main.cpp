@@ -46,19 +46,29 @@ void printTokensTest(std::string_view input) {
 }
 
 void print_json(const JsonNode &node,
-                std::string_view whole_file,
+                const LineIndex &line_index,
                 int level = 0) {
     for (int i = 0; i < level; ++i) {
         std::cout << "  ";
     }
 
-    TokenLocation location = get_token_position(node.value(), whole_file);
-    std::cout << token_type_to_string(node.value().type) << ": "
-              << node.value().value << " (Line: " << location.line_number
+    TokenLocation location = line_index.location(node.value());
+    auto value = node.value().value;
+    if (node.value().type == TokenType::BEGIN_OBJECT ||
+        node.value().type == TokenType::BEGIN_ARRAY) {
+        // Containers refers to all of their content
+        value = value.substr(0, 1);
+    }
+    std::cout << token_type_to_string(node.value().type) << ": " << value
+              << " (Line: " << location.line_number
               << ", Column: " << location.column_number << ")" << std::endl;
 
+    if (!node.children()) {
+        return;
+    }
+
     for (const auto &child : node) {
-        print_json(child, whole_file, level + 1);
+        print_json(child, line_index, level + 1);
     }
 }
 
@@ -153,7 +163,7 @@ int main() {
     //    printTokensTest(example_data2);
     const JsonRoot root = parse_json(example_data2);
     //    auto &root = nodes.front();
-    print_json(root.nodes.front(), example_data2);
+    print_json(root.nodes.front(), LineIndex{example_data2});
 
     if (auto person = root->find("person")) {
         std::cout << "found 'person' in root" << std::endl;
@@ -0,0 +1,85 @@
+#include "fast-json/json.h"
+#include "fast-json/jsonout.h"
+#include "fast-json/utils.h"
+#include <array>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+
+const auto example = std::string_view{
+    R"({"name": "John\nDoe", "courses": ["math", "history"], "ages": [1, 2, 3]})"};
+
+} // namespace
+
+TEST(Allocator, ParseIntoArena) {
+    // All memory is taken from the buffer, anything else throws bad_alloc
+    auto buffer = std::array<std::byte, 8192>{};
+    auto arena = std::pmr::monotonic_buffer_resource{
+        buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+
+    auto root = json::parse_json(example, &arena);
+
+    EXPECT_EQ(root["name"].str(&arena), "John\nDoe");
+
+    auto courses = std::pmr::vector<std::pmr::string>{&arena};
+    root["courses"].get_to(courses);
+    ASSERT_EQ(courses.size(), 2);
+    EXPECT_EQ(courses.at(0), "math");
+    EXPECT_EQ(courses.at(1), "history");
+    EXPECT_EQ(courses.at(1).get_allocator().resource(), &arena);
+}
+
+TEST(Allocator, ContainerDeserialization) {
+    auto root = json::parse_json(example);
+
+    auto ages = root["ages"].as<std::vector<int>>();
+    EXPECT_EQ(ages, (std::vector<int>{1, 2, 3}));
+
+    EXPECT_THROW(root["name"].as<std::vector<int>>(), std::invalid_argument);
+}
+
+TEST(Allocator, ContainerSerialization) {
+    auto ss = std::stringstream{};
+    {
+        auto out = json::JsonOut::inlined(ss);
+        out["strings"] = std::pmr::vector<std::pmr::string>{"a", "b"};
+        out["empty"] = std::vector<int>{};
+    }
+
+    auto str = ss.str();
+    auto root = json::parse_json(str);
+    EXPECT_EQ(root["strings"].as<std::vector<std::string>>(),
+              (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(root["empty"].value().type, json::TokenType::BEGIN_ARRAY);
+    EXPECT_EQ(root["empty"].children(), nullptr);
+}
+
+#ifdef __linux__
+TEST(Allocator, ReadFilesWithoutSize) {
+    // Larger than what is read at a time, but fits in the buffer of the pipe
+    auto text = "[" + std::string(50000, ' ') + "1]";
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], text.data(), text.size()),
+              static_cast<ssize_t>(text.size()));
+    close(fds[1]);
+    auto arena = std::pmr::monotonic_buffer_resource{};
+    auto content = json::read_file_content(
+        "/proc/self/fd/" + std::to_string(fds[0]), &arena);
+    close(fds[0]);
+    EXPECT_EQ(std::string_view{content}, text);
+
+    // Files in /proc have a size of 0
+    auto status = json::read_file_content("/proc/self/status");
+    EXPECT_NE(status.find("Name:"), std::string::npos);
+}
+#endif
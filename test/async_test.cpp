@@ -0,0 +1,160 @@
+#include "fast-json/async.h"
+#include <coroutine>
+#include <deque>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Gives the data in small pieces without suspending
+struct ChunkedSource {
+    std::string_view data;
+    size_t chunk_size = 3;
+
+    struct ReadAwaiter {
+        size_t size;
+
+        bool await_ready() const {
+            return true;
+        }
+
+        void await_suspend(std::coroutine_handle<>) {}
+
+        size_t await_resume() const {
+            return size;
+        }
+    };
+
+    ReadAwaiter read(std::span<char> buffer) {
+        auto size = std::min({chunk_size, buffer.size(), data.size()});
+        std::copy_n(data.begin(), size, buffer.begin());
+        data.remove_prefix(size);
+        return {size};
+    }
+};
+
+/// A minimal event loop where reads wait until data is pushed
+struct EventLoop {
+    std::deque<std::coroutine_handle<>> ready;
+
+    void run() {
+        while (!ready.empty()) {
+            auto h = ready.front();
+            ready.pop_front();
+            h.resume();
+        }
+    }
+};
+
+struct Connection {
+    EventLoop &loop;
+    std::deque<std::string> packets;
+
+    struct ReadAwaiter {
+        Connection &connection;
+        std::span<char> buffer;
+
+        bool await_ready() const {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            // Wait for the next turn of the event loop
+            connection.loop.ready.push_back(h);
+        }
+
+        size_t await_resume() {
+            auto &packets = connection.packets;
+            if (packets.empty()) {
+                return 0;
+            }
+            auto size = std::min(buffer.size(), packets.front().size());
+            std::copy_n(packets.front().begin(), size, buffer.begin());
+            packets.front().erase(0, size);
+            if (packets.front().empty()) {
+                packets.pop_front();
+            }
+            return size;
+        }
+    };
+
+    ReadAwaiter read(std::span<char> buffer) {
+        return {*this, buffer};
+    }
+};
+
+template <typename Source>
+json::Task<> collect(Source &source,
+                     json::SplitMode mode,
+                     std::vector<int> &values,
+                     std::vector<std::string> *log = nullptr,
+                     std::string name = {}) {
+    auto records = json::parse_records_async(source, mode);
+    while (auto root = co_await records.next()) {
+        values.push_back((*root)->at("id").number());
+        if (log) {
+            log->push_back(name);
+        }
+    }
+}
+
+} // namespace
+
+TEST(Async, ParseDocument) {
+    auto source = ChunkedSource{R"({"a": [1, 2, 3], "b": "text"})"};
+    auto buffer = std::string{};
+    auto task = json::parse_json_async(source, buffer);
+    task.start();
+    ASSERT_TRUE(task.is_done());
+    auto root = task.get();
+    EXPECT_EQ(root["a"].size(), 3);
+    EXPECT_EQ(root["b"].str(), "text");
+}
+
+TEST(Async, Records) {
+    auto ndjson = ChunkedSource{"{\"id\": 1}\n{\"id\": 2, \"x\": \"}\"}\n{\"id\": 3}"};
+    auto values = std::vector<int>{};
+    auto task = collect(ndjson, json::SplitMode::Values, values);
+    task.start();
+    ASSERT_TRUE(task.is_done());
+    task.get();
+    EXPECT_EQ(values, (std::vector<int>{1, 2, 3}));
+
+    auto array = ChunkedSource{R"([{"id": 4}, {"id": 5}] )"};
+    values.clear();
+    auto array_task = collect(array, json::SplitMode::ArrayElements, values);
+    array_task.start();
+    array_task.get();
+    EXPECT_EQ(values, (std::vector<int>{4, 5}));
+}
+
+TEST(Async, InterleavedConnections) {
+    auto loop = EventLoop{};
+    auto a = Connection{loop, {"{\"id\": 1}\n{\"i", "d\": 2}\n"}};
+    auto b = Connection{loop, {"{\"id\": 10}\n", "{\"id\": 20}\n"}};
+
+    auto log = std::vector<std::string>{};
+    auto values_a = std::vector<int>{};
+    auto values_b = std::vector<int>{};
+    auto task_a = collect(a, json::SplitMode::Values, values_a, &log, "a");
+    auto task_b = collect(b, json::SplitMode::Values, values_b, &log, "b");
+    task_a.start();
+    task_b.start();
+    loop.run();
+
+    ASSERT_TRUE(task_a.is_done());
+    ASSERT_TRUE(task_b.is_done());
+    EXPECT_EQ(values_a, (std::vector<int>{1, 2}));
+    EXPECT_EQ(values_b, (std::vector<int>{10, 20}));
+    EXPECT_EQ(log, (std::vector<std::string>{"a", "b", "a", "b"}));
+}
+
+TEST(Async, ErrorsArePropagated) {
+    auto source = ChunkedSource{"{\"id\": 1}\n{\"id\": ]\n"};
+    auto values = std::vector<int>{};
+    auto task = collect(source, json::SplitMode::Values, values);
+    task.start();
+    EXPECT_THROW(task.get(), json::ParseError);
+    EXPECT_EQ(values, (std::vector<int>{1}));
+}
@@ -0,0 +1,134 @@
+#include "fast-json/batchload.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace {
+
+class BatchLoad : public ::testing::TestWithParam<bool> {
+protected:
+    void SetUp() override {
+        _dir = std::filesystem::temp_directory_path() /
+               ("fast_json_batchload_test_" +
+                std::to_string(GetParam() ? 1 : 0));
+        std::filesystem::create_directories(_dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(_dir);
+    }
+
+    std::filesystem::path write_file(std::string_view name,
+                                     std::string_view content) {
+        auto path = _dir / name;
+        auto file = std::ofstream{path, std::ios::binary};
+        file.write(content.data(),
+                   static_cast<std::streamsize>(content.size()));
+        return path;
+    }
+
+    json::BatchLoadOptions options() const {
+        auto options = json::BatchLoadOptions{};
+        options.num_threads = 3;
+        options.queue_depth = 8;
+        options.use_io_uring = GetParam();
+        return options;
+    }
+
+    std::filesystem::path _dir;
+};
+
+} // namespace
+
+TEST_P(BatchLoad, LoadsAllFiles) {
+    auto paths = std::vector<std::filesystem::path>{};
+    for (int i = 0; i < 200; ++i) {
+        // Some files are larger than a single read
+        auto padding = std::string(i % 10 == 0 ? 300000 : i, ' ');
+        paths.push_back(write_file(std::to_string(i) + ".json",
+                                   R"({"id": )" + std::to_string(i) +
+                                       padding + "}"));
+    }
+
+    auto seen = std::vector<int>(paths.size());
+    json::load_files(
+        paths,
+        [&](json::LoadedFile &file) {
+            ASSERT_FALSE(file.error);
+            ASSERT_TRUE(file.document);
+            EXPECT_EQ(file.path, paths[file.index]);
+            EXPECT_EQ((*file.document)["id"].number<size_t>(), file.index);
+            ++seen[file.index];
+        },
+        options());
+    EXPECT_EQ(seen, std::vector<int>(paths.size(), 1));
+}
+
+TEST_P(BatchLoad, ErrorsArePerFile) {
+    auto paths = std::vector<std::filesystem::path>{
+        write_file("valid.json", "[1, 2, 3]"),
+        _dir / "missing.json",
+        write_file("invalid.json", R"({"id": })"),
+        write_file("empty.json", ""),
+    };
+
+    auto errors = std::vector<bool>(paths.size());
+    json::load_files(
+        paths,
+        [&](json::LoadedFile &file) {
+            errors[file.index] = static_cast<bool>(file.error);
+            EXPECT_EQ(!file.document, errors[file.index]);
+        },
+        options());
+    EXPECT_EQ(errors, (std::vector<bool>{false, true, true, true}));
+}
+
+TEST_P(BatchLoad, Fifo) {
+    // Has no size, so it is read as a stream
+    auto fifo = _dir / "fifo.json";
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+    auto writer = std::thread{[&] {
+        auto file = std::ofstream{fifo, std::ios::binary};
+        file << R"({"id": 1})";
+    }};
+    auto paths = std::vector<std::filesystem::path>{
+        write_file("file.json", R"({"id": 0})"), fifo};
+
+    auto seen = std::vector<int>(paths.size());
+    json::load_files(
+        paths,
+        [&](json::LoadedFile &file) {
+            ASSERT_FALSE(file.error);
+            EXPECT_EQ((*file.document)["id"].number<size_t>(), file.index);
+            ++seen[file.index];
+        },
+        options());
+    writer.join();
+    EXPECT_EQ(seen, std::vector<int>(paths.size(), 1));
+}
+
+TEST_P(BatchLoad, StopEarly) {
+    auto paths = std::vector<std::filesystem::path>{};
+    for (int i = 0; i < 100; ++i) {
+        paths.push_back(write_file(std::to_string(i) + ".json", "{}"));
+    }
+
+    auto loader = json::BatchLoader{paths, options()};
+    if (!GetParam()) {
+        EXPECT_FALSE(loader.uses_io_uring());
+    }
+    ASSERT_TRUE(loader.next());
+    // The remaining files are dropped by the destructor
+}
+
+TEST_P(BatchLoad, NoFiles) {
+    auto loader = json::BatchLoader{{}, options()};
+    EXPECT_FALSE(loader.next());
+}
+
+INSTANTIATE_TEST_SUITE_P(IoUring, BatchLoad, ::testing::Bool());
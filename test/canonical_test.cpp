@@ -0,0 +1,57 @@
+#include "fast-json/canonical.h"
+#include "fast-json/hash.h"
+#include "fast-json/json.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+std::string canonical(std::string_view input) {
+    auto root = json::parse_json(input);
+    return json::to_canonical_string(*root);
+}
+
+} // namespace
+
+TEST(Canonical, Numbers) {
+    EXPECT_EQ(canonical("[1e30, 4.50, 2e-3, 0.000001, 1e-7, 1e21, 1e20]"),
+              "[1e+30,4.5,0.002,0.000001,1e-7,1e+21,100000000000000000000]");
+    EXPECT_EQ(canonical("[333333333.33333329, -0, 5e-324, 9007199254740992]"),
+              "[333333333.3333333,0,5e-324,9007199254740992]");
+    EXPECT_EQ(canonical("[1.7976931348623157e308, -1.5E+2, 10]"),
+              "[1.7976931348623157e+308,-150,10]");
+}
+
+TEST(Canonical, SortedKeys) {
+    // The example from RFC 8785, section 3.2.3
+    EXPECT_EQ(canonical(R"({
+        "\u20ac": "Euro Sign",
+        "\r": "Carriage Return",
+        "\ufb33": "Hebrew Letter Dalet With Dagesh",
+        "1": "One",
+        "\ud83d\ude00": "Emoji: Grinning Face",
+        "\u0080": "Control",
+        "\u00f6": "Latin Small Letter O With Diaeresis"
+    })"),
+              "{\"\\r\":\"Carriage Return\",\"1\":\"One\",\"\xc2\x80\":"
+              "\"Control\",\"ö\":\"Latin Small Letter O With Diaeresis\","
+              "\"€\":\"Euro Sign\",\"😀\":\"Emoji: Grinning Face\","
+              "\"\xef\xac\xb3\":\"Hebrew Letter Dalet With Dagesh\"}");
+}
+
+TEST(Canonical, EquivalentDocuments) {
+    auto a = std::string_view{
+        R"({"b": [true, null, "\u0041\/"], "a": {"y": 1.0, "x": 2e0}})"};
+    auto b = std::string_view{R"({ "a":{"x":2,"y":1},"b":[true,null,"A/"] })"};
+    EXPECT_EQ(canonical(a), canonical(b));
+    EXPECT_EQ(canonical(a), R"({"a":{"x":2,"y":1},"b":[true,null,"A/"]})");
+
+    auto root_a = json::parse_json(a);
+    auto root_b = json::parse_json(b);
+    EXPECT_EQ(json::structural_hash128(*root_a),
+              json::structural_hash128(*root_b));
+    EXPECT_EQ(json::structural_hash128(*root_a).low,
+              json::structural_hash(*root_a));
+    EXPECT_NE(json::structural_hash128(*root_a).low,
+              json::structural_hash128(*root_a).high);
+}
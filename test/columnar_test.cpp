@@ -0,0 +1,145 @@
+#include "fast-json/columnar.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const auto input = std::string_view{
+    R"({"id": 1, "user": {"name": "anna", "score": 1.5}, "active": true})"
+    "\n"
+    R"({"user": {"score": null, "name": "bård"}, "id": 2, "x": [1, {}]})"
+    "\n"
+    R"({"id": 3, "active": false, "user": "not a object"})"
+    "\n"};
+
+const auto specs = std::vector<json::ColumnSpec>{
+    {"/id", json::ColumnType::Int64},
+    {"/user/name", json::ColumnType::String},
+    {"/user/score", json::ColumnType::Double},
+    {"/active", json::ColumnType::Bool},
+};
+
+} // namespace
+
+TEST(Columnar, ExtractColumns) {
+    auto columns = json::extract_columns(input, specs);
+    ASSERT_EQ(columns.size(), 4u);
+    for (auto &column : columns) {
+        EXPECT_EQ(column.size(), 3u);
+    }
+
+    auto ids = columns[0].int64s();
+    EXPECT_EQ(std::vector<int64_t>(ids.begin(), ids.end()),
+              (std::vector<int64_t>{1, 2, 3}));
+    EXPECT_EQ(columns[0].null_count(), 0u);
+
+    EXPECT_EQ(columns[1].string(0), "anna");
+    EXPECT_EQ(columns[1].string(1), "b\xc3\xa5rd");
+    EXPECT_TRUE(columns[1].is_null(2));
+    EXPECT_EQ(columns[1].string(2), "");
+
+    EXPECT_EQ(columns[2].doubles()[0], 1.5);
+    EXPECT_TRUE(columns[2].is_null(1));
+    EXPECT_TRUE(columns[2].is_null(2));
+    EXPECT_EQ(columns[2].null_count(), 2u);
+
+    EXPECT_TRUE(columns[3].is_valid(0));
+    EXPECT_TRUE(columns[3].is_null(1));
+    EXPECT_EQ(columns[3].bools()[0], 1);
+    EXPECT_EQ(columns[3].bools()[2], 0);
+    EXPECT_EQ(columns[3].validity()[0], 0b101u);
+}
+
+TEST(Columnar, ParallelIsTheSame) {
+    auto text = std::string{};
+    for (int i = 0; i < 1000; ++i) {
+        text += R"({"id": )" + std::to_string(i) + R"(, "user": {"name": "u)" +
+                std::to_string(i) + "\"}" +
+                (i % 3 ? R"(, "active": true)" : "") + "}\n";
+    }
+    auto expected = json::extract_columns(text, specs);
+    for (size_t num_threads : {2, 3, 8}) {
+        auto columns = json::extract_columns(text, specs, num_threads);
+        ASSERT_EQ(columns[0].size(), 1000u);
+        for (size_t j = 0; j < columns.size(); ++j) {
+            EXPECT_EQ(columns[j].null_count(), expected[j].null_count());
+        }
+        EXPECT_TRUE(std::ranges::equal(columns[0].int64s(),
+                                       expected[0].int64s()));
+        EXPECT_EQ(columns[1].chars(), expected[1].chars());
+        EXPECT_TRUE(std::ranges::equal(columns[1].offsets(),
+                                       expected[1].offsets()));
+        EXPECT_TRUE(std::ranges::equal(columns[3].validity(),
+                                       expected[3].validity()));
+        EXPECT_EQ(columns[1].string(999), "u999");
+    }
+}
+
+TEST(Columnar, Errors) {
+    auto one = std::vector<json::ColumnSpec>{{"/id", json::ColumnType::Int64}};
+    EXPECT_THROW(json::extract_columns("{\"id\": 1.5}\n", one),
+                 json::ParseError);
+    EXPECT_THROW(json::extract_columns("[1]\n", one), json::ParseError);
+    EXPECT_THROW(json::extract_columns(R"({"id": 1, "x": garbage})", one),
+                 json::ParseError);
+    EXPECT_THROW(json::extract_columns(R"({"x": {"y":}, "id": 1})", one),
+                 json::ParseError);
+    EXPECT_THROW(json::extract_columns(R"({"x": [1 2], "id": 1})", one),
+                 json::ParseError);
+
+    // Not null terminated, so that reading past the end is noticed
+    for (auto truncated : {R"({"id\)", R"({"x": "a\)"}) {
+        auto buffer = std::vector<char>(truncated,
+                                        truncated + std::strlen(truncated));
+        EXPECT_THROW(json::extract_columns({buffer.data(), buffer.size()}, one),
+                     json::ParseError)
+            << truncated;
+    }
+
+    try {
+        json::extract_columns("{\"id\": 1}\n{\"id\": 2}\n{\"id\": \"3\"}\n",
+                              one,
+                              2);
+        FAIL() << "expected error";
+    }
+    catch (const json::ParseError &e) {
+        EXPECT_EQ(e.line(), 3u);
+    }
+
+    auto invalid = std::vector<json::ColumnSpec>{{"id"}};
+    EXPECT_THROW(json::extract_columns("{}", invalid), std::invalid_argument);
+    EXPECT_THROW(json::extract_columns("{}", one)[0].doubles(),
+                 std::invalid_argument);
+}
+
+TEST(Columnar, ArrayElements) {
+    auto paths = std::vector<json::ColumnSpec>{
+        {"/items/0/id", json::ColumnType::Int64},
+        {"/items/1/id", json::ColumnType::Int64},
+        {"/values/1", json::ColumnType::Double},
+    };
+    auto columns = json::extract_columns(
+        R"({"items": [{"id": 5}, {"id": 6}], "values": [1, 2.5]})"
+        "\n"
+        R"({"items": [{"id": 7}], "values": {"1": 3}})",
+        paths);
+    ASSERT_EQ(columns[0].size(), 2u);
+    EXPECT_EQ(columns[0].int64s()[0], 5);
+    EXPECT_EQ(columns[0].int64s()[1], 7);
+    EXPECT_EQ(columns[1].int64s()[0], 6);
+    EXPECT_TRUE(columns[1].is_null(1));
+    EXPECT_EQ(columns[2].doubles()[0], 2.5);
+    EXPECT_EQ(columns[2].doubles()[1], 3);
+}
+
+TEST(Columnar, EscapedKeys) {
+    auto pointer = std::vector<json::ColumnSpec>{
+        {"/a~1b", json::ColumnType::Double}};
+    auto columns =
+        json::extract_columns(R"({"a\/b": 2} {"a/b": 3})", pointer);
+    ASSERT_EQ(columns[0].size(), 2u);
+    EXPECT_EQ(columns[0].doubles()[0], 2);
+    EXPECT_EQ(columns[0].doubles()[1], 3);
+}
@@ -0,0 +1,146 @@
+#include "fast-json/decompress.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::filesystem::path temp_path(std::string_view name) {
+    return std::filesystem::temp_directory_path() /
+           ("fast_json_decompress_test_" + std::string{name});
+}
+
+void write_file(const std::filesystem::path &path, std::string_view content) {
+    auto file = std::ofstream{path, std::ios::binary};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+std::string generate_records(int num_records) {
+    auto str = std::string{};
+    for (int i = 0; i < num_records; ++i) {
+        str += R"({"id": )" + std::to_string(i) + R"(, "name": "x"})" "\n";
+    }
+    return str;
+}
+
+std::vector<int> read_ids(const std::filesystem::path &path,
+                          json::SplitMode mode = json::SplitMode::Values) {
+    auto ids = std::vector<int>{};
+    json::for_each_compressed_record(
+        path,
+        [&](const json::JsonNode &node) {
+            ids.push_back(node["id"].number<int>());
+        },
+        mode,
+        {},
+        1000); // Small chunks so that records are split between them
+    return ids;
+}
+
+#ifdef FAST_JSON_HAS_ZLIB
+std::string gzip(std::string_view content) {
+    auto stream = z_stream{};
+    deflateInit2(&stream, 6, Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY);
+    auto out = std::string(deflateBound(&stream, content.size()) + 32, '\0');
+    stream.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(content.data()));
+    stream.avail_in = static_cast<uInt>(content.size());
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+#endif
+
+} // namespace
+
+TEST(Decompress, DetectCompression) {
+    EXPECT_EQ(json::detect_compression("\x1f\x8b\x08"),
+              json::Compression::Gzip);
+    EXPECT_EQ(json::detect_compression("\x28\xb5\x2f\xfd"),
+              json::Compression::Zstd);
+    EXPECT_EQ(json::detect_compression("{}"), json::Compression::None);
+    EXPECT_EQ(json::detect_compression(""), json::Compression::None);
+}
+
+TEST(Decompress, PlainFile) {
+    auto path = temp_path("plain.ndjson");
+    auto content = generate_records(500);
+    write_file(path, content);
+
+    EXPECT_EQ(json::read_decompressed_content(path), content);
+    auto ids = read_ids(path);
+    ASSERT_EQ(ids.size(), 500u);
+    EXPECT_EQ(ids.back(), 499);
+
+    std::filesystem::remove(path);
+}
+
+TEST(Decompress, MissingFile) {
+    EXPECT_THROW(json::read_decompressed_content(temp_path("missing")),
+                 std::runtime_error);
+}
+
+TEST(Decompress, ParseErrorIsRethrown) {
+    auto path = temp_path("invalid.ndjson");
+    write_file(path, generate_records(100) + "{\"id\": }\n" +
+                         generate_records(100));
+    EXPECT_THROW(read_ids(path), json::ParseError);
+    std::filesystem::remove(path);
+}
+
+#ifdef FAST_JSON_HAS_ZLIB
+
+TEST(Decompress, Gzip) {
+    auto path = temp_path("records.ndjson.gz");
+    auto content = generate_records(2000);
+    write_file(path, gzip(content));
+
+    auto reader = json::DecompressingReader{path};
+    EXPECT_EQ(reader.compression(), json::Compression::Gzip);
+    EXPECT_EQ(json::read_decompressed_content(path), content);
+
+    auto ids = read_ids(path);
+    ASSERT_EQ(ids.size(), 2000u);
+    for (int i = 0; i < 2000; ++i) {
+        EXPECT_EQ(ids[i], i);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(Decompress, ConcatenatedGzipMembers) {
+    auto path = temp_path("members.ndjson.gz");
+    write_file(path, gzip(generate_records(10)) + gzip(generate_records(10)));
+    EXPECT_EQ(read_ids(path).size(), 20u);
+    std::filesystem::remove(path);
+}
+
+TEST(Decompress, GzipArrayElements) {
+    auto path = temp_path("array.json.gz");
+    auto content = std::string{"["};
+    for (int i = 0; i < 1000; ++i) {
+        content += (i ? ", " : "") + std::string{R"({"id": )"} +
+                   std::to_string(i) + "}";
+    }
+    content += "]";
+    write_file(path, gzip(content));
+    auto ids = read_ids(path, json::SplitMode::ArrayElements);
+    ASSERT_EQ(ids.size(), 1000u);
+    EXPECT_EQ(ids.back(), 999);
+    std::filesystem::remove(path);
+}
+
+TEST(Decompress, TruncatedGzip) {
+    auto path = temp_path("truncated.ndjson.gz");
+    auto data = gzip(generate_records(1000));
+    write_file(path, data.substr(0, data.size() / 2));
+    EXPECT_THROW(json::read_decompressed_content(path), std::runtime_error);
+    EXPECT_THROW(read_ids(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+#endif
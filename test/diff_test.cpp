@@ -0,0 +1,100 @@
+#include "fast-json/diff.h"
+#include "fast-json/hash.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+/// Apply the diff to `a` and check that the result is equal to `b`
+void expect_roundtrip(std::string_view a, std::string_view b) {
+    auto root_a = json::parse_json(a);
+    auto root_b = json::parse_json(b);
+    auto patch = json::diff_patch(*root_a, *root_b);
+
+    auto doc = json::MutableDocument{a};
+    doc.apply_patch(patch);
+    EXPECT_TRUE(json::json_internal::equal(*doc, *root_b))
+        << a << " -> " << b << "\npatch: " << patch << "\nresult: "
+        << json::to_json_string(doc);
+}
+
+} // namespace
+
+TEST(Hash, EqualValuesHasEqualHashes) {
+    auto a = json::parse_json(R"({"x": [1, 2.0, "a\/b"], "y": {"z": null}})");
+    auto b = json::parse_json(R"({"y": {"z": null}, "x": [1.0, 2, "a/b"]})");
+    auto c = json::parse_json(R"({"y": {"z": null}, "x": [2, 1, "a/b"]})");
+    EXPECT_EQ(json::structural_hash(*a), json::structural_hash(*b));
+    EXPECT_NE(json::structural_hash(*a), json::structural_hash(*c));
+
+    auto cache = json::HashCache{};
+    auto h = json::structural_hash(*a, &cache);
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_EQ(json::structural_hash(*a, &cache), h);
+}
+
+TEST(Hash, CacheOfReusedNodes) {
+    // The parser places the nodes of the next document at the same addresses
+    auto parser = json::Parser{};
+    auto cache = json::HashCache{};
+    auto first = std::string{R"({"x": [1, 2], "y": {}})"};
+    auto second = std::string{R"({"x": [1, 3], "y": {}})"};
+    auto h1 = json::structural_hash(*parser.parse(first), &cache);
+    auto &root = parser.parse(second);
+    EXPECT_NE(json::structural_hash(*root, &cache), h1);
+    EXPECT_EQ(json::structural_hash(*root, &cache),
+              json::structural_hash(*root));
+}
+
+TEST(Diff, Changes) {
+    auto a = json::parse_json(
+        R"({"name": "x", "list": [1, 2, 3, 4], "same": {"deep": [1]}})");
+    auto b = json::parse_json(
+        R"({"list": [1, 5, 3, 4, 6], "same": {"deep": [1]}, "new": true})");
+    auto changes = json::diff(*a, *b);
+
+    ASSERT_EQ(changes.size(), 4);
+    EXPECT_EQ(changes[0].type, json::Change::Type::Remove);
+    EXPECT_EQ(changes[0].path, "/name");
+    EXPECT_EQ(changes[1].type, json::Change::Type::Replace);
+    EXPECT_EQ(changes[1].path, "/list/1");
+    EXPECT_EQ(changes[1].value->number(), 5);
+    EXPECT_EQ(changes[2].type, json::Change::Type::Add);
+    EXPECT_EQ(changes[2].path, "/list/4");
+    EXPECT_EQ(changes[3].path, "/new");
+
+    EXPECT_EQ(json::diff_patch(*a, *a), "[]");
+}
+
+TEST(Diff, NumbersOutsideDoubleRange) {
+    auto a = json::parse_json(R"({"x": 1e400, "y": 1, "z": -1e-400})");
+    auto b = json::parse_json(R"({"x": 1e400, "y": 2, "z": -1e-400})");
+    EXPECT_EQ(json::diff_patch(*a, *b),
+              R"([{"op":"replace","path":"/y","value":2}])");
+
+    auto c = json::parse_json(R"({"x": 2e400, "y": 1, "z": -1e-400})");
+    EXPECT_NE(json::structural_hash(*a), json::structural_hash(*c));
+    ASSERT_EQ(json::diff(*a, *c).size(), 1);
+    EXPECT_EQ(json::diff(*a, *c)[0].path, "/x");
+}
+
+TEST(Diff, PatchRoundtrip) {
+    expect_roundtrip(R"([1, 2, 3, 4, 5])", R"([1, 5])");
+    expect_roundtrip(R"([1, 5])", R"([0, 1, 2, 3, 5])");
+    expect_roundtrip(R"({"a/b": {"c~d": 1}})", R"({"a/b": {"c~d": 2}})");
+    expect_roundtrip(R"({"a": [1, {"b": 2}]})", R"({"a": {"b": 2}})");
+    expect_roundtrip(R"("x")", R"(["x"])");
+
+    auto big_a = std::string{"{"};
+    auto big_b = std::string{"{"};
+    for (int i = 0; i < 40; ++i) {
+        auto key = "\"k" + std::to_string(i) + "\": ";
+        big_a += (i ? ", " : "") + key + std::to_string(i);
+        if (i % 7) {
+            big_b += (big_b.size() > 1 ? ", " : "") + key +
+                     std::to_string(i % 5 ? i : -i);
+        }
+    }
+    big_b += R"(, "extra": [])";
+    expect_roundtrip(big_a + "}", big_b + "}");
+}
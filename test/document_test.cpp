@@ -0,0 +1,111 @@
+#include "fast-json/document.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string make_config(int version) {
+    auto v = std::to_string(version);
+    return R"({"version": )" + v + R"(, "copy": )" + v +
+           R"(, "list": [1, 2, 3]})";
+}
+
+} // namespace
+
+TEST(Document, OwnsItsText) {
+    auto document = json::Document::parse(make_config(1));
+    auto copy = document;
+    document.reset();
+    EXPECT_EQ(copy->root().at("version").number(), 1);
+    EXPECT_EQ((*copy)["list"].size(), 3);
+
+    EXPECT_THROW(json::Document::parse("{\"a\": }"), json::ParseError);
+}
+
+TEST(AtomicDocument, ReloadWhileReading) {
+    auto config = json::AtomicDocument{json::Document::parse(make_config(0))};
+    auto is_running = std::atomic_bool{true};
+    auto num_errors = std::atomic_int{0};
+
+    auto readers = std::vector<std::thread>{};
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            int last_version = 0;
+            while (is_running) {
+                auto snapshot = config.load();
+                auto version = (*snapshot)["version"].number();
+                // A snapshot is never changed and versions only increase
+                if (version != (*snapshot)["copy"].number() ||
+                    version < last_version) {
+                    ++num_errors;
+                }
+                last_version = version;
+            }
+        });
+    }
+
+    auto old = config.load();
+    for (int version = 1; version <= 200; ++version) {
+        config.reload(make_config(version));
+    }
+    EXPECT_THROW(config.reload("{\"version\": }"), json::ParseError);
+
+    is_running = false;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(num_errors, 0);
+    EXPECT_EQ(config.load()->root().at("version").number(), 200);
+    EXPECT_EQ(old->root().at("version").number(), 0);
+}
+
+TEST(Document, SharedBuffer) {
+    auto buffer = std::make_shared<const std::string>(
+        "{\"id\": 1, \"tags\": [\"a\"]}\n{\"id\": 2, \"tags\": []}\n3");
+    auto documents = json::Document::parse_records(buffer);
+    ASSERT_EQ(documents.size(), 3u);
+    EXPECT_EQ(buffer.use_count(), 4);
+
+    // The text is not copied
+    EXPECT_EQ(documents[1]->text().data(),
+              buffer->data() + buffer->find('\n') + 1);
+    EXPECT_EQ(documents[1]->buffer(), buffer);
+    EXPECT_EQ(documents[2]->root().number(), 3);
+
+    buffer.reset();
+    EXPECT_EQ((*documents[0])["tags"][0].str(), "a");
+
+    auto other = std::make_shared<const std::string>("[1]");
+    EXPECT_THROW(json::Document::parse(other, "[1]"), std::invalid_argument);
+    EXPECT_FALSE(json::Document::parse("[1]")->buffer());
+}
+
+TEST(NodeRef, KeepsDocumentAlive) {
+    auto tag = json::NodeRef{};
+    auto missing = json::NodeRef{};
+    {
+        auto buffer = std::make_shared<const std::string>(
+            R"({"order": {"tags": ["a", "b"]}})");
+        auto root = json::NodeRef{json::Document::parse(buffer, *buffer)};
+        tag = root["order"]["tags"][1];
+        missing = root["order"].find("missing");
+        EXPECT_TRUE(root["order"].find("tags"));
+    }
+    ASSERT_TRUE(tag);
+    EXPECT_EQ(tag->str(), "b");
+    EXPECT_EQ(tag.shared().use_count(), 1);
+    EXPECT_FALSE(missing);
+    EXPECT_FALSE(json::NodeRef{nullptr});
+
+    // Handles can be passed to other threads and outlive the other handles
+    auto copy = tag;
+    auto thread = std::thread{[ref = std::move(copy)] {
+        EXPECT_EQ(ref->str(), "b");
+    }};
+    tag = {};
+    thread.join();
+}
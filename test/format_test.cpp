@@ -0,0 +1,74 @@
+#include "fast-json/format.h"
+#include "fast-json/json.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace {
+
+const auto example = std::string_view{R"( {
+    "name" : "John \"the\" Doe",
+    "values":[1.5, -2e3 ,{ }, [],
+       {"x":  "a b\\"}],
+    "empty": {}
+} )"};
+
+const auto minified = std::string_view{
+    R"({"name":"John \"the\" Doe","values":[1.5,-2e3,{},[],{"x":"a b\\"}],"empty":{}})"};
+
+const auto pretty = std::string_view{R"({
+  "name": "John \"the\" Doe",
+  "values": [
+    1.5,
+    -2e3,
+    {},
+    [],
+    {
+      "x": "a b\\"
+    }
+  ],
+  "empty": {}
+})"};
+
+} // namespace
+
+TEST(Format, Minify) {
+    EXPECT_EQ(json::minify(example), minified);
+    EXPECT_EQ(json::minify(pretty), minified);
+}
+
+TEST(Format, Prettify) {
+    EXPECT_EQ(json::prettify(example), pretty);
+    EXPECT_EQ(json::prettify(minified), pretty);
+    EXPECT_EQ(json::minify(json::prettify(example, 4)), minified);
+}
+
+TEST(Format, Streams) {
+    auto in = std::istringstream{std::string{example}};
+    auto out = std::ostringstream{};
+    json::prettify(in, out);
+    EXPECT_EQ(out.str(), pretty);
+}
+
+TEST(Format, SplitInput) {
+    // Every possible split point should give the same result
+    for (int indent : {-1, 2}) {
+        auto formatter = json::json_internal::Reformatter{indent};
+        auto result = std::string{};
+        for (char c : example) {
+            formatter.feed({&c, 1}, result);
+        }
+        formatter.finish();
+        EXPECT_EQ(result, indent < 0 ? minified : pretty);
+    }
+}
+
+TEST(Format, UnterminatedString) {
+    EXPECT_THROW(json::minify(R"({"x": "abc)"), std::runtime_error);
+}
+
+TEST(Format, DumpKeepsNumbers) {
+    auto root = json::parse_json(R"({"x": 1.5})");
+    auto ss = std::ostringstream{};
+    ss << *root;
+    EXPECT_NE(ss.str().find("1.5"), std::string::npos);
+}
@@ -0,0 +1,117 @@
+#include "fast-json/incremental.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+namespace {
+
+/// Compare with a document that is parsed from the start, including the
+/// positions of all nodes in the text
+void expect_same_as_full_parse(const json::IncrementalDocument &doc) {
+    auto text = doc.text();
+    auto expected = json::parse_json(text);
+
+    auto compare = [&](auto &self,
+                       const json::JsonNode &a,
+                       const json::JsonNode &b) -> void {
+        ASSERT_EQ(a.value().type, b.value().type);
+        ASSERT_EQ(doc.offset(a), b.source().data() - text.data());
+        ASSERT_EQ(a.source(), b.source());
+        ASSERT_EQ(a.size(), b.size());
+        auto x = a.children();
+        auto y = b.children();
+        for (; x && y; x = x->next(), y = y->next()) {
+            self(self, *x, *y);
+        }
+        ASSERT_EQ(x, nullptr);
+        ASSERT_EQ(y, nullptr);
+    };
+    compare(compare, doc.root(), *expected);
+}
+
+} // namespace
+
+TEST(Incremental, EditValue) {
+    auto doc = json::IncrementalDocument{
+        R"({"a": [1, 2, 3], "b": {"c": "x"}, "d": true})"};
+    auto offset = doc.text().find('2');
+
+    auto &changed = doc.apply_edit(offset, 1, "200");
+    EXPECT_EQ(changed.source(), "[1, 200, 3]");
+    EXPECT_EQ(doc["a"][1].number<int>(), 200);
+    EXPECT_EQ(doc["b"]["c"].str(), "x");
+    EXPECT_TRUE(doc["d"].boolean());
+    expect_same_as_full_parse(doc);
+}
+
+TEST(Incremental, SmallestContainer) {
+    auto doc = json::IncrementalDocument{R"([[1, [2, 3]], {"k": [4]}])"};
+    auto &changed = doc.apply_edit(doc.text().find('3'), 0, "5, ");
+    EXPECT_EQ(changed.source(), "[2, 5, 3]");
+    expect_same_as_full_parse(doc);
+
+    // Keys are in the object that contains them
+    auto &object = doc.apply_edit(doc.text().find('k'), 1, "key");
+    EXPECT_EQ(object.source(), R"({"key": [4]})");
+    EXPECT_EQ(doc->at(1)["key"][0].number<int>(), 4);
+    expect_same_as_full_parse(doc);
+}
+
+TEST(Incremental, EditOutsideOfContainers) {
+    auto doc = json::IncrementalDocument{"[1, 2]"};
+    doc.apply_edit(0, 0, "  ");
+    expect_same_as_full_parse(doc);
+    doc.apply_edit(0, doc.text().size(), "\"str\"");
+    EXPECT_EQ(doc->str(), "str");
+}
+
+TEST(Incremental, StructuralEdit) {
+    auto doc = json::IncrementalDocument{"[[1, 2], 3]"};
+
+    // The new text of the inner array is "[1], [2]", so the parent is parsed
+    auto &changed = doc.apply_edit(doc.text().find(','), 1, "], [");
+    EXPECT_EQ(&changed, &doc.root());
+    EXPECT_EQ(doc->size(), 3u);
+    expect_same_as_full_parse(doc);
+}
+
+TEST(Incremental, InvalidEdit) {
+    auto doc = json::IncrementalDocument{R"({"a": [1, 2]})"};
+    EXPECT_THROW(doc.apply_edit(doc.text().find('2'), 1, "\""),
+                 json::ParseError);
+    EXPECT_FALSE(doc.is_valid());
+
+    // Fixing the text makes the document valid again
+    doc.apply_edit(doc.text().find('"', 9), 1, "3");
+    ASSERT_TRUE(doc.is_valid());
+    EXPECT_EQ(doc["a"][1].number<int>(), 3);
+    expect_same_as_full_parse(doc);
+
+    EXPECT_THROW(doc.apply_edit(100, 0, ""), std::out_of_range);
+    EXPECT_THROW(doc.apply_edit(0, 100, ""), std::out_of_range);
+}
+
+TEST(Incremental, RandomEdits) {
+    auto doc = json::IncrementalDocument{R"({"items": []})"};
+    auto random = std::mt19937{1};
+    auto values = {R"("text")", "12", "null", "[]", R"({"x": [0]})", "false"};
+
+    for (int i = 0; i < 500; ++i) {
+        // Add a value at the end of a random array or object
+        auto text = std::string{doc.text()};
+        auto brackets = std::vector<size_t>{};
+        for (size_t pos = 0; pos < text.size(); ++pos) {
+            if (text[pos] == ']' || text[pos] == '}') {
+                brackets.push_back(pos);
+            }
+        }
+        auto pos = brackets[random() % brackets.size()];
+        auto value = std::string{values.begin()[random() % values.size()]};
+        auto is_empty = text[pos - 1] == '[' || text[pos - 1] == '{';
+        if (text[pos] == '}') {
+            value = "\"k" + std::to_string(i) + "\": " + value;
+        }
+        doc.apply_edit(pos, 0, is_empty ? value : ", " + value);
+        ASSERT_NO_FATAL_FAILURE(expect_same_as_full_parse(doc));
+    }
+}
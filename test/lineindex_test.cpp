@@ -0,0 +1,60 @@
+#include "fast-json/json.h"
+#include "fast-json/lineindex.h"
+#include <gtest/gtest.h>
+
+TEST(LineIndex, Locations) {
+    auto text = std::string_view{"{\n  \"a\": 1,\n\n  \"b\": [true]\n}"};
+    auto index = json::LineIndex{text};
+
+    EXPECT_EQ(index.num_lines(), 5);
+    EXPECT_EQ(index.location(0), (json::TokenLocation{1, 1}));
+    EXPECT_EQ(index.location(2), (json::TokenLocation{2, 1}));
+    EXPECT_EQ(index.location(text.find("true")), (json::TokenLocation{4, 9}));
+    EXPECT_EQ(index.location(text.size() - 1), (json::TokenLocation{5, 1}));
+    EXPECT_THROW(index.location(text.size() + 1), std::out_of_range);
+}
+
+TEST(LineIndex, MatchesTokenPosition) {
+    auto text = std::string_view{"[\n1,\n  \"two\",\n    {\"three\": 3}\n]"};
+    auto root = json::parse_json(text);
+    auto index = json::LineIndex{text};
+
+    for (auto &node : root.nodes) {
+        EXPECT_EQ(index.location(node.value()),
+                  json::get_token_position(node.value(), text))
+            << node.value().value;
+    }
+}
+
+TEST(LineIndex, ParseErrorLocation) {
+    auto options = json::ParseOptions{.strict = true};
+    try {
+        json::parse_json("{\n  \"a\": 1,\n  \"b\": 02\n}", options);
+        FAIL() << "expected a parse error";
+    }
+    catch (const json::ParseError &e) {
+        EXPECT_EQ(e.line(), 3);
+        EXPECT_EQ(e.column(), 8);
+        EXPECT_EQ(e.offset(), 19);
+    }
+
+    try {
+        json::parse_json("[1,\n 2,\n]", options);
+        FAIL() << "expected a parse error";
+    }
+    catch (const json::ParseError &e) {
+        EXPECT_EQ(e.line(), 3);
+        EXPECT_EQ(e.column(), 1);
+    }
+}
+
+TEST(LineIndex, LenientParseErrorLocation) {
+    try {
+        json::parse_json("{\n  \"a\": \"multi\nline\",\n  \"b\": :\n}");
+        FAIL() << "expected a parse error";
+    }
+    catch (const json::ParseError &e) {
+        EXPECT_EQ(e.line(), 4);
+        EXPECT_EQ(e.column(), 8);
+    }
+}
@@ -0,0 +1,175 @@
+#include "fast-json/mutabledocument.h"
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+
+namespace {
+
+const auto example = std::string_view{
+    R"({"name": "John", "age": 30, "courses": ["math", "history"]})"};
+
+} // namespace
+
+TEST(MutableDocument, AddReplaceRemove) {
+    auto doc = json::MutableDocument{example};
+
+    doc.add("/city", R"("New York")");
+    doc.add("/courses/1", R"("chemistry")");
+    doc.add("/courses/-", R"({"name": "art"})");
+    doc.replace("/age", "31");
+    doc.remove("/name");
+
+    EXPECT_EQ(doc["city"].str(), "New York");
+    EXPECT_EQ(doc["age"].number(), 31);
+    EXPECT_EQ(doc->find("name"), nullptr);
+    EXPECT_EQ(doc.get("/courses/0").str(), "math");
+    EXPECT_EQ(doc.get("/courses/1").str(), "chemistry");
+    EXPECT_EQ(doc.get("/courses/2").str(), "history");
+    EXPECT_EQ(doc.get("/courses/3/name").str(), "art");
+
+    EXPECT_THROW(doc.remove("/missing"), std::out_of_range);
+    EXPECT_THROW(doc.add("/courses/10", "1"), std::out_of_range);
+
+    // Only digits without leading zeros are array indices
+    for (auto index : {"-1", "+1", "01", "", "1x", "99999999999999999999"}) {
+        auto pointer = std::string{"/courses/"} + index;
+        EXPECT_THROW(doc.add(pointer, "9"), std::out_of_range) << pointer;
+        EXPECT_THROW(doc.remove(pointer), std::out_of_range) << pointer;
+    }
+    EXPECT_EQ(doc["courses"].size(), 4);
+}
+
+TEST(MutableDocument, RenameAndEscapedKeys) {
+    auto doc = json::MutableDocument{example};
+
+    doc.rename("/name", "first/name");
+    EXPECT_EQ(doc.get("/first~1name").str(), "John");
+    EXPECT_THROW(doc.rename("/age", "courses"), std::invalid_argument);
+
+    doc.add("/quote\"d", "true");
+    EXPECT_TRUE(doc.get("/quote\"d").boolean());
+}
+
+TEST(MutableDocument, ModifiedNodes) {
+    auto doc = json::MutableDocument{example};
+    doc.replace("/courses/0", R"("art")");
+
+    EXPECT_TRUE(doc.is_modified(*doc));
+    EXPECT_TRUE(doc.is_modified(doc["courses"]));
+    EXPECT_FALSE(doc.is_modified(doc["age"]));
+}
+
+TEST(MutableDocument, ApplyPatch) {
+    auto doc = json::MutableDocument{example};
+
+    doc.apply_patch(R"([
+        {"op": "test", "path": "/name", "value": "John"},
+        {"op": "replace", "path": "/name", "value": "Jane"},
+        {"op": "add", "path": "/address", "value": {"city": "Paris"}},
+        {"op": "move", "from": "/age", "path": "/address/age"},
+        {"op": "copy", "from": "/courses/0", "path": "/courses/-"},
+        {"op": "remove", "path": "/courses/1"}
+    ])");
+
+    EXPECT_EQ(doc["name"].str(), "Jane");
+    EXPECT_EQ(doc.get("/address/city").str(), "Paris");
+    EXPECT_EQ(doc.get("/address/age").number(), 30);
+    EXPECT_EQ(doc->find("age"), nullptr);
+    EXPECT_EQ(doc["courses"].as<std::vector<std::string>>(),
+              (std::vector<std::string>{"math", "math"}));
+}
+
+TEST(MutableDocument, FailedPatchIsReverted) {
+    auto doc = json::MutableDocument{example};
+
+    EXPECT_THROW(doc.apply_patch(R"([
+        {"op": "remove", "path": "/courses/0"},
+        {"op": "add", "path": "/x", "value": 1},
+        {"op": "test", "path": "/age", "value": 20}
+    ])"),
+                 std::runtime_error);
+
+    EXPECT_EQ(doc->find("x"), nullptr);
+    EXPECT_EQ(doc["courses"].as<std::vector<std::string>>(),
+              (std::vector<std::string>{"math", "history"}));
+    EXPECT_FALSE(doc.is_modified(*doc));
+}
+
+TEST(MutableDocument, IndexingAfterEdits) {
+    auto doc = json::MutableDocument{R"({"values": [0, 1, 2, 3]})"};
+
+    doc.remove("/values/1");
+    doc.add("/values/-", "4");
+    doc.add("/values/0", "-1");
+
+    auto &values = doc["values"];
+    ASSERT_EQ(values.size(), 5);
+    auto expected = std::vector<int>{-1, 0, 2, 3, 4};
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(values[i].number(), expected[i]);
+    }
+    EXPECT_EQ(doc->size(), 1);
+
+    EXPECT_THROW(doc.apply_patch(R"([
+        {"op": "remove", "path": "/values/0"},
+        {"op": "remove", "path": "/missing"}
+    ])"),
+                 std::out_of_range);
+    EXPECT_EQ(doc["values"].size(), 5);
+    EXPECT_EQ(doc["values"][0].number(), -1);
+}
+
+TEST(MutableDocument, EditsKeepChildrenInPlace) {
+    auto doc = json::MutableDocument{R"({"values": [], "empty": []})"};
+
+    // Appending grows the elements to twice the size when they are full
+    auto blocks = std::set<const json::JsonNode *>{};
+    for (int i = 0; i < 1000; ++i) {
+        doc.add("/values/-", std::to_string(i));
+        blocks.insert(doc["values"].children());
+    }
+    EXPECT_LE(blocks.size(), 10);
+
+    // Inserting and removing moves the elements within the same memory
+    auto children = doc["values"].children();
+    for (int i = 0; i < 100; ++i) {
+        doc.remove("/values/0");
+        doc.add("/values/998", std::to_string(1000 + i));
+    }
+    EXPECT_EQ(doc["values"].children(), children);
+    auto &values = doc["values"];
+    ASSERT_EQ(values.size(), 1000);
+    EXPECT_EQ(values[0].number(), 100);
+    EXPECT_EQ(values[998].number(), 1099);
+    EXPECT_EQ(values[999].number(), 999);
+    size_t i = 0;
+    for (auto &element : values) {
+        EXPECT_EQ(&element, &values.elements()[i++]);
+    }
+    EXPECT_EQ(i, values.size());
+
+    // A container that becomes empty gives its memory to the next one
+    doc.add("/empty/-", "1");
+    children = doc["empty"].children();
+    for (int i = 0; i < 10; ++i) {
+        doc.remove("/empty/0");
+        EXPECT_EQ(doc["empty"].children(), nullptr);
+        doc.add("/empty/-", "1");
+        EXPECT_EQ(doc["empty"].children(), children);
+    }
+
+    // Moved elements are restored by a failed patch
+    EXPECT_THROW(doc.apply_patch(R"([
+        {"op": "add", "path": "/values/0", "value": -1},
+        {"op": "move", "from": "/values/1", "path": "/values/-"},
+        {"op": "remove", "path": "/missing"}
+    ])"),
+                 std::out_of_range);
+    EXPECT_EQ(doc["values"].size(), 1000);
+    EXPECT_EQ(doc["values"][0].number(), 100);
+    EXPECT_EQ(doc["values"][999].number(), 999);
+
+    doc.apply_patch(R"([{"op": "move", "from": "/values/0", "path": "/x"}])");
+    EXPECT_EQ(doc["x"].number(), 100);
+    EXPECT_EQ(doc["values"][0].number(), 101);
+}
@@ -0,0 +1,117 @@
+#include "fast-json/parallelout.h"
+#include "fast-json/json.h"
+#include "fast-json/serialize.h"
+#include <gtest/gtest.h>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Record {
+    int id = 0;
+    std::string name;
+    std::vector<double> values;
+
+    FAST_JSON_SERIALIZE_INTRUSIVE(id, name, values);
+};
+
+std::vector<Record> generate_records(size_t size) {
+    auto records = std::vector<Record>{};
+    for (size_t i = 0; i < size; ++i) {
+        records.push_back({static_cast<int>(i),
+                           "record \"" + std::to_string(i) + "\"",
+                           {i * 0.5, 1.0}});
+    }
+    return records;
+}
+
+template <typename T>
+std::string sequential(const T &values, int indent_width) {
+    auto ss = std::ostringstream{};
+    {
+        auto out = json::JsonOut{ss, indent_width};
+        out["list"] = values;
+        out["after"] = 1;
+    }
+    return ss.str();
+}
+
+template <typename T>
+std::string parallel(const T &values, int indent_width, size_t num_threads) {
+    auto ss = std::ostringstream{};
+    {
+        auto out = json::JsonOut{ss, indent_width};
+        auto list = out["list"];
+        json::write_array_parallel(list, values, num_threads, 4);
+        list.finish();
+        out["after"] = 1;
+    }
+    return ss.str();
+}
+
+} // namespace
+
+TEST(ParallelOut, SameAsSequential) {
+    auto records = generate_records(103);
+    for (int indent_width : {2, 4, -1}) {
+        auto expected = sequential(records, indent_width);
+        for (size_t num_threads : {1, 2, 3, 8, 64}) {
+            EXPECT_EQ(parallel(records, indent_width, num_threads), expected)
+                << "indent " << indent_width << ", threads " << num_threads;
+        }
+    }
+}
+
+TEST(ParallelOut, Numbers) {
+    auto numbers = std::vector<int>(1000);
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        numbers[i] = static_cast<int>(i);
+    }
+    auto str = parallel(numbers, 2, 7);
+    EXPECT_EQ(str, sequential(numbers, 2));
+
+    auto root = json::parse_json(str);
+    ASSERT_EQ((*root)["list"].size(), 1000u);
+    EXPECT_EQ((*root)["list"][999].number<int>(), 999);
+}
+
+TEST(ParallelOut, StreamFormat) {
+    auto numbers = std::vector<double>(100, 3.14159265358979);
+    auto print = [&](size_t num_threads) {
+        auto ss = std::ostringstream{};
+        ss << std::setprecision(15);
+        {
+            auto out = json::JsonOut{ss, -1};
+            json::write_array_parallel(out, numbers, num_threads, 2);
+        }
+        return ss.str();
+    };
+    auto str = print(4);
+    EXPECT_EQ(str, print(1));
+    EXPECT_NE(str.find("3.14159265358979"), std::string::npos);
+}
+
+TEST(ParallelOut, SmallAndEmptyRanges) {
+    auto empty = std::vector<int>{};
+    EXPECT_EQ(parallel(empty, 2, 4), sequential(empty, 2));
+
+    auto small = std::vector<int>{1, 2, 3};
+    EXPECT_EQ(parallel(small, -1, 4), sequential(small, -1));
+}
+
+TEST(ParallelOut, TopLevelArray) {
+    auto records = generate_records(50);
+    auto expected = std::ostringstream{};
+    {
+        auto out = json::JsonOut{expected};
+        out = records;
+    }
+    auto ss = std::ostringstream{};
+    {
+        auto out = json::JsonOut{ss};
+        json::write_array_parallel(out, records, 4, 4);
+    }
+    EXPECT_EQ(ss.str(), expected.str());
+}
@@ -0,0 +1,204 @@
+#include "fast-json/json.h"
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <new>
+#include <string>
+
+namespace {
+
+/// Number of allocations from the global heap, to check that the parser only
+/// uses its memory resource
+size_t num_global_allocations = 0;
+
+/// Count the number of allocations made through the resource
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t num_allocations = 0;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        ++num_allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+} // namespace
+
+void *operator new(size_t size) {
+    ++num_global_allocations;
+    if (auto p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+TEST(Parser, ParseSeveralDocuments) {
+    auto parser = json::Parser{};
+
+    {
+        auto &root = parser.parse(R"({"a": [1, 2, 3, 4, 5], "b": "x\ty"})");
+        auto numbers = std::vector<int>{};
+        root["a"].get_to(numbers);
+        EXPECT_EQ(numbers, (std::vector<int>{1, 2, 3, 4, 5}));
+        EXPECT_EQ(parser.str(root["b"]), "x\ty");
+    }
+
+    {
+        auto &root = parser.parse(R"(["hello", {"there": true}])");
+        EXPECT_EQ(root->front().raw(), "hello");
+        EXPECT_TRUE(root->front().next()->at("there").boolean());
+    }
+}
+
+TEST(Parser, ReusedNodesAreRewritten) {
+    auto parser = json::Parser{};
+    parser.parse(R"({"a": {"b": [1, 2]}, "c": [3, [4]]})");
+
+    // Nothing is left from the document before
+    auto &root = parser.parse(R"({"a", "c": [[], {}]})");
+    ASSERT_EQ(root->size(), 2);
+    EXPECT_EQ(root->front().children(), nullptr);
+    auto &c = root->front().next()->front();
+    ASSERT_EQ(c.size(), 2);
+    EXPECT_TRUE(c[0].empty());
+    EXPECT_EQ(c[0].children(), nullptr);
+    EXPECT_EQ(c[1].children(), nullptr);
+    EXPECT_EQ(c[1].next(), nullptr);
+
+    EXPECT_EQ(parser.parse(",")->value().type, json::TokenType::INVALID);
+    EXPECT_EQ(parser.parse(",")->children(), nullptr);
+}
+
+TEST(Parser, NoAllocationsWhenWarm) {
+    auto resource = CountingResource{};
+    auto parser = json::Parser{&resource};
+
+    auto large = std::string{R"({"values": [)"};
+    for (int i = 0; i < 100; ++i) {
+        large += std::to_string(i) + ", ";
+    }
+    large += R"("end"], "name": "large\nname"})";
+
+    auto &root = parser.parse(large);
+    EXPECT_EQ(parser.str(root["name"]), "large\nname");
+
+    auto allocations = resource.num_allocations;
+
+    for (int i = 0; i < 10; ++i) {
+        auto &root = parser.parse(R"({"name": "small\tname", "x": [1, 2]})");
+        EXPECT_EQ(parser.str(root["name"]), "small\tname");
+        parser.parse(large);
+    }
+
+    EXPECT_EQ(resource.num_allocations, allocations);
+}
+
+TEST(Parser, NoAllocationsWhenWarmStrict) {
+    auto resource = CountingResource{};
+    auto parser = json::Parser{json::ParseOptions{.strict = true}, &resource};
+
+    // Deeper than the small string buffer of the kinds of open containers
+    auto deep = std::string(100, '[') + std::string(100, ']');
+    parser.parse(deep);
+
+    auto allocations = resource.num_allocations;
+    auto global_allocations = num_global_allocations;
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(parser.parse(deep)->size(), 1);
+    }
+
+    EXPECT_EQ(resource.num_allocations, allocations);
+#ifndef FAST_JSON_PROFILE_ACCESS
+    // The access profiler keeps the documents on the global heap
+    EXPECT_EQ(num_global_allocations, global_allocations);
+#endif
+}
+
+TEST(Parser, TokensRefersToInput) {
+    auto input = std::string_view{R"( { "a" : [ 1 ] } )"};
+    auto root = json::parse_json(input);
+
+    EXPECT_EQ(root->value().value.data(), input.data() + 1);
+    EXPECT_EQ(root["a"].value().value.data(), input.data() + 9);
+}
+
+TEST(Parser, EmptyInput) {
+    auto parser = json::Parser{};
+    EXPECT_THROW(parser.parse("   "), std::runtime_error);
+
+    // Lenient input without a value has a empty root
+    auto root = json::parse_json(",");
+    EXPECT_EQ(root->value().type, json::TokenType::INVALID);
+    EXPECT_EQ(root->children(), nullptr);
+}
+
+TEST(Parser, DeepNesting) {
+    auto depth = size_t{100000};
+    auto input = std::string(depth, '[') + std::string(depth, ']');
+
+    EXPECT_THROW(json::parse_json(input), json::ParseError);
+
+    // Does not depend on the size of the call stack
+    auto root = json::parse_json(input, json::ParseOptions{.max_depth = depth});
+    EXPECT_EQ(root.nodes.size(), depth);
+    EXPECT_EQ(root->size(), 1);
+    EXPECT_EQ(root->value().value, input);
+
+    auto options = json::ParseOptions{.max_depth = 2};
+    EXPECT_NO_THROW(json::parse_json("[[1], {\"a\": 2}]", options));
+    EXPECT_THROW(json::parse_json("[[1], {\"a\": []}]", options),
+                 json::ParseError);
+
+    // Fails at the first container past the limit, before the rest of the
+    // input is read
+    try {
+        json::parse_json(std::string(depth, '[') + "@", options);
+        FAIL() << "expected ParseError";
+    }
+    catch (const json::ParseError &e) {
+        EXPECT_EQ(e.offset(), 2);
+        EXPECT_EQ(e.column(), 3);
+    }
+}
+
+TEST(Parser, ChildrenAreContiguous) {
+    auto input = std::string{
+        R"({"a": [1, {"b": null}, [], "x"], "c": {"d": {"e": true}}, "f": 2})"};
+    auto root = json::parse_json(input);
+
+    EXPECT_EQ(root->size(), 3);
+    auto &a = root["a"];
+    ASSERT_EQ(a.size(), 4);
+    EXPECT_EQ(a[0].number(), 1);
+    EXPECT_EQ(a[1]["b"].value().type, json::TokenType::NULL_VALUE);
+    EXPECT_TRUE(a[2].empty());
+    EXPECT_EQ(a[3].str(), "x");
+    EXPECT_THROW(a.at(4), std::out_of_range);
+    EXPECT_THROW(root->at(0), std::invalid_argument);
+    EXPECT_EQ(root["c"]["d"]["e"].boolean(), true);
+
+    // The linked list and the contiguous layout describes the same elements
+    size_t i = 0;
+    for (auto &element : a) {
+        EXPECT_EQ(&element, &a.elements()[i++]);
+    }
+    EXPECT_EQ(i, a.size());
+}
@@ -0,0 +1,97 @@
+#include "fast-json/prefilter.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> select(std::string_view input,
+                                const json::RecordFilter &filter) {
+    auto records = std::vector<std::string>{};
+    json::for_each_matching_record(
+        input, filter, [&](std::string_view record, const json::JsonNode &) {
+            records.emplace_back(record);
+        });
+    return records;
+}
+
+/// The same filter without the prefilter
+std::vector<std::string> select_slow(std::string_view input,
+                                     const json::RecordFilter &filter) {
+    auto records = std::vector<std::string>{};
+    for (size_t pos = 0; pos < input.size();) {
+        auto end = std::min(input.find('\n', pos), input.size());
+        auto line = input.substr(pos, end - pos);
+        if (line.find_first_not_of(" \t\r") != std::string_view::npos &&
+            filter.matches(*json::parse_json(line))) {
+            records.emplace_back(line);
+        }
+        pos = end + 1;
+    }
+    return records;
+}
+
+} // namespace
+
+TEST(Prefilter, FindSubstring) {
+    auto text = std::string(100, 'a') + "needle" + std::string(20, 'b');
+    auto end = text.data() + text.size();
+    EXPECT_EQ(json::json_internal::find_substring(text.data(), end, "needle"),
+              text.data() + 100);
+    EXPECT_EQ(json::json_internal::find_substring(text.data(), end, "needles"),
+              end);
+    EXPECT_EQ(json::json_internal::find_substring(text.data(), end, "b"),
+              text.data() + 106);
+    EXPECT_EQ(json::json_internal::find_substring(text.data(), end, "dleb"),
+              text.data() + 103);
+    EXPECT_EQ(json::json_internal::find_substring(text.data(), end, ""),
+              text.data());
+}
+
+TEST(Prefilter, SelectRecords) {
+    auto input = std::string_view{
+        R"({"level": "error", "msg": "disk full"})"
+        "\n"
+        R"({"level": "info", "msg": "level error"})"
+        "\n"
+        "\n"
+        R"({"msg": "\"error\"", "level": "warning"})"
+        "\n"
+        R"({"level":"error","user":{"id": 10}})"
+        "\n"
+        R"({"level": "error", "user": {"id": 1e1}})"};
+
+    auto filter = json::RecordFilter{};
+    filter.equals("/level", "\"error\"");
+    auto records = select(input, filter);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0], R"({"level": "error", "msg": "disk full"})");
+    EXPECT_EQ(records, select_slow(input, filter));
+
+    filter.equals("/user/id", "10");
+    records = select(input, filter);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records, select_slow(input, filter));
+
+    EXPECT_FALSE(filter.may_match(R"({"level": "info"})"));
+    EXPECT_TRUE(filter.matches(R"({"user": {"id": 10.0}, "level": "error"})"));
+}
+
+TEST(Prefilter, EmptyFilterSelectsAll) {
+    auto input = std::string_view{"{}\n\n[1]\n  \n2"};
+    EXPECT_EQ(select(input, json::RecordFilter{}).size(), 3u);
+}
+
+TEST(Prefilter, SameAsParsingAllRecords) {
+    auto input = std::string{};
+    for (int i = 0; i < 500; ++i) {
+        input += R"({"id": )" + std::to_string(i % 7) +
+                 R"(, "tag": ")" + (i % 5 ? "a/b" : "a\\/b") +
+                 R"(", "ok": )" + (i % 3 ? "true" : "false") + "}\n";
+    }
+    auto filter = json::RecordFilter{};
+    filter.equals("/tag", "\"a/b\"").equals("/ok", "true").equals("/id", "3");
+    auto records = select(input, filter);
+    EXPECT_FALSE(records.empty());
+    EXPECT_EQ(records, select_slow(input, filter));
+}
@@ -0,0 +1,168 @@
+#ifndef FAST_JSON_PROFILE_ACCESS
+#define FAST_JSON_PROFILE_ACCESS
+#endif
+
+#include "fast-json/document.h"
+#include "fast-json/json.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const auto order = std::string{R"({
+    "id": 17,
+    "customer": {"name": "Ann", "address": {"city": "Lund", "zip": "22100"}},
+    "items": [{"sku": "a", "qty": 1}, {"sku": "b", "qty": 2}],
+    "notes": "a long text that nobody reads"
+})"};
+
+/// Read a part of the order, as a service would
+int read_order(const json::JsonNode &root) {
+    int sum = root["id"].number<int>();
+    for (auto &item : root["items"]) {
+        sum += item["qty"].number<int>();
+    }
+    if (root.find("missing")) {
+        sum = 0;
+    }
+    root["customer"].visit([&](auto name, auto &value) {
+        if (name == "name") {
+            sum += static_cast<int>(value.str().size());
+        }
+    });
+    return sum;
+}
+
+class Profile : public ::testing::Test {
+protected:
+    void SetUp() override {
+        json::AccessProfiler::global().reset();
+    }
+};
+
+} // namespace
+
+TEST_F(Profile, CountsReads) {
+    auto root = json::parse_json(order);
+    auto &profiler = json::AccessProfiler::global();
+    EXPECT_EQ(profiler.report().documents, 1u);
+    EXPECT_EQ(profiler.report().find("/id")->accesses, 0u);
+
+    EXPECT_EQ(read_order(*root), 23);
+    // Found by at() and read by number()
+    EXPECT_EQ(profiler.report().find("/id")->accesses, 2u);
+    EXPECT_EQ(profiler.report().find("/id")->num_read, 1u);
+}
+
+TEST_F(Profile, Report) {
+    for (int i = 0; i < 3; ++i) {
+        auto root = json::parse_json(order);
+        read_order(*root);
+    }
+    auto report = json::AccessProfiler::global().report();
+    EXPECT_EQ(report.documents, 3u);
+    EXPECT_EQ(report.bytes, 3 * order.size());
+
+    auto id = report.find("/id");
+    ASSERT_TRUE(id);
+    EXPECT_EQ(id->count, 3u);
+    EXPECT_EQ(id->num_read, 3u);
+    EXPECT_EQ(id->accesses, 6u);
+    EXPECT_EQ(id->unused_bytes(), 0u);
+
+    // Elements of arrays have the same path
+    auto qty = report.find("/items/*/qty");
+    ASSERT_TRUE(qty);
+    EXPECT_EQ(qty->count, 6u);
+    EXPECT_EQ(qty->accesses, 12u);
+    auto sku = report.find("/items/*/sku");
+    ASSERT_TRUE(sku);
+    EXPECT_EQ(sku->num_read, 0u);
+    EXPECT_EQ(sku->unused_bytes(), 3 * 2 * 3u);
+
+    auto notes = report.find("/notes");
+    ASSERT_TRUE(notes);
+    EXPECT_EQ(notes->unused_bytes(), 3 * 31u);
+    EXPECT_EQ(report.find("/customer/address")->num_read, 0u);
+    EXPECT_EQ(report.find("/customer")->num_read, 3u);
+    EXPECT_FALSE(report.find("/missing"));
+
+    // "17" + 2 * "1" + "\"Ann\"" in each document
+    EXPECT_EQ(report.used_bytes, 3 * 9u);
+    EXPECT_EQ(report.wasted_bytes(), report.bytes - report.used_bytes);
+
+    EXPECT_EQ(report.used_paths(),
+              (std::vector<std::string>{
+                  "/customer/name", "/id", "/items/*/qty"}));
+    EXPECT_NE(report.to_string().find("/items/*/qty"), std::string::npos);
+}
+
+TEST_F(Profile, ParserAndDocument) {
+    {
+        // The text does not have to outlive the parser
+        auto parser = json::Parser{};
+        parser.parse(std::string{order})["id"].number<int>();
+        parser.parse(std::string{order})["notes"].str();
+    }
+    auto document = json::Document::parse(order);
+    (*document)["notes"].raw();
+
+    auto report = json::AccessProfiler::global().report();
+    EXPECT_EQ(report.documents, 3u);
+    EXPECT_EQ(report.find("/id")->accesses, 2u);
+    EXPECT_EQ(report.find("/notes")->accesses, 4u);
+    EXPECT_EQ(report.find("/notes")->num_read, 2u);
+}
+
+TEST_F(Profile, Threads) {
+    {
+        auto threads = std::vector<std::jthread>{};
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([] {
+                for (int j = 0; j < 100; ++j) {
+                    read_order(*json::parse_json(order));
+                }
+            });
+        }
+    }
+    auto report = json::AccessProfiler::global().report();
+    EXPECT_EQ(report.documents, 400u);
+    EXPECT_EQ(report.find("/id")->accesses, 800u);
+}
+
+TEST_F(Profile, Disabled) {
+    json::AccessProfiler::global().enable(false);
+    read_order(*json::parse_json(order));
+    json::AccessProfiler::global().enable();
+    EXPECT_EQ(json::AccessProfiler::global().report().documents, 0u);
+
+    // Values that were parsed when it was disabled are not counted
+    auto root = json::parse_json(order);
+    json::AccessProfiler::global().enable(false);
+    read_order(*root);
+    json::AccessProfiler::global().enable();
+    EXPECT_EQ(json::AccessProfiler::global().report().find("/id")->accesses,
+              0u);
+}
+
+TEST_F(Profile, EscapedKeys) {
+    json::parse_json(R"({"a/b": {"c~d": 1}, "e": 2})")
+        ->at("a/b")
+        .at("c~d")
+        .number<int>();
+    auto report = json::AccessProfiler::global().report();
+    EXPECT_TRUE(report.find("/a~1b/c~0d"));
+    EXPECT_TRUE(report.find("/e"));
+}
+
+TEST_F(Profile, KeyWithoutValue) {
+    // Accepted in lenient mode
+    json::parse_json(R"({"a"})");
+    json::parse_json(R"({"a", "b": 1})");
+    auto report = json::AccessProfiler::global().report();
+    EXPECT_EQ(report.documents, 2u);
+    EXPECT_FALSE(report.find("/a"));
+    EXPECT_EQ(report.find("/b")->count, 1u);
+}
@@ -0,0 +1,105 @@
+#include "fast-json/schema.h"
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Address {
+    std::string street;
+    int number = 0;
+};
+
+struct Person {
+    std::string name;
+    int age = 0;
+    bool active = false;
+    std::vector<double> scores;
+    Address address;
+    std::optional<std::string> nickname;
+};
+
+} // namespace
+
+template <>
+struct json::schema_for<Address>
+    : json::Schema<Address,
+                   json::field<"street", &Address::street>,
+                   json::field<"number", &Address::number>> {};
+
+template <>
+struct json::schema_for<Person>
+    : json::Schema<Person,
+                   json::field<"name", &Person::name>,
+                   json::field<"age", &Person::age>,
+                   json::field<"active", &Person::active>,
+                   json::field<"scores", &Person::scores>,
+                   json::field<"address", &Person::address>,
+                   json::field<"nickname", &Person::nickname>> {};
+
+TEST(Schema, ParseIntoStruct) {
+    auto person = json::parse_as<Person>(R"({
+        "name": "Jöhn \"J\" Doe",
+        "age": 42,
+        "unknown": {"skipped": [1, {"x": "]"}]},
+        "active": true,
+        "scores": [1.5, -2, 3e2],
+        "address": {"street": "Main Street", "number": 10}
+    })");
+
+    EXPECT_EQ(person.name, "Jöhn \"J\" Doe");
+    EXPECT_EQ(person.age, 42);
+    EXPECT_TRUE(person.active);
+    EXPECT_EQ(person.scores, (std::vector<double>{1.5, -2, 300}));
+    EXPECT_EQ(person.address.street, "Main Street");
+    EXPECT_EQ(person.address.number, 10);
+    EXPECT_FALSE(person.nickname);
+
+    auto address = json::Schema<Address,
+                                json::field<"street", &Address::street>,
+                                json::field<"number", &Address::number>>::
+        parse(R"({"number": 2, "street": "x"})");
+    EXPECT_EQ(address.number, 2);
+}
+
+TEST(Schema, RejectMismatches) {
+    auto fails_at = [](std::string_view input) -> size_t {
+        try {
+            json::parse_as<Address>(input);
+        }
+        catch (const json::ParseError &e) {
+            return e.offset();
+        }
+        return std::string_view::npos;
+    };
+
+    EXPECT_EQ(fails_at(R"({"street": 10, "number": 1})"), 11);
+    EXPECT_EQ(fails_at(R"({"street": "x", "number": 1.5})"), 26);
+    EXPECT_EQ(fails_at(R"({"street": "x", "number": "1"})"), 26);
+    EXPECT_EQ(fails_at(R"({"street": "x"})"), 15); // Missing number
+    EXPECT_EQ(fails_at(R"([])"), 0);
+    EXPECT_EQ(fails_at(R"({"street": "x", "number": 1} 2)"), 29);
+    EXPECT_EQ(fails_at(R"({"street": "x", "number": 1})"),
+              std::string_view::npos);
+
+    // Skipped values are checked too
+    EXPECT_EQ(fails_at(R"({"u": [1, -2.5e3, true, null, "s", {"a": {}}],
+                           "street": "x", "number": 1})"),
+              std::string_view::npos);
+    EXPECT_EQ(fails_at(R"({"u": garbage, "street": "x", "number": 1})"), 6);
+    EXPECT_EQ(fails_at(R"({"u": {"x":}, "street": "x", "number": 1})"), 11);
+    for (auto skipped : {"tru", "nul", "01", "1.", "-", "[1 2]", "[1,]", "]",
+                         "{\"a\" 1}", "{\"a\": 1,}", "{1: 2}", "[:]",
+                         "[1}", "{\"a\": 1]", "[[]"}) {
+        auto input = std::string{R"({"u": )"} + skipped +
+                     R"(, "street": "x", "number": 1})";
+        EXPECT_NE(fails_at(input), std::string_view::npos) << input;
+    }
+
+    // A escape at the end of the input, that is not null terminated so that
+    // reading past the end is noticed
+    auto truncated = std::string_view{R"({"street":"abc\)"};
+    auto buffer = std::vector<char>(truncated.begin(), truncated.end());
+    EXPECT_EQ(fails_at({buffer.data(), buffer.size()}), 10);
+}
@@ -0,0 +1,49 @@
+#include "fast-json/splitter.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Feed the input one byte at a time and collect the records
+std::vector<std::string> split(std::string_view input, json::SplitMode mode) {
+    auto splitter = json::RecordSplitter{mode};
+    auto buffer = std::string{};
+    auto records = std::vector<std::string>{};
+    for (auto c : input) {
+        buffer.push_back(c);
+        for (auto record = splitter.next(buffer); !record.empty();
+             record = splitter.next(buffer)) {
+            records.emplace_back(record);
+        }
+        auto consumed = splitter.consumed();
+        buffer.erase(0, consumed);
+        splitter.discard(consumed);
+    }
+    if (auto record = splitter.finish(buffer); !record.empty()) {
+        records.emplace_back(record);
+    }
+    return records;
+}
+
+} // namespace
+
+TEST(RecordSplitter, Values) {
+    auto records = split("{\"a\": \"}\\\"\"}\n[1, [2]]\n\"str\"  10\ntrue",
+                         json::SplitMode::Values);
+    EXPECT_EQ(records,
+              (std::vector<std::string>{
+                  "{\"a\": \"}\\\"\"}", "[1, [2]]", "\"str\"", "10", "true"}));
+}
+
+TEST(RecordSplitter, ArrayElements) {
+    auto records = split(R"( [ {"x": [1, 2]}, 3.5 ,"]", [], null ] )",
+                         json::SplitMode::ArrayElements);
+    EXPECT_EQ(records,
+              (std::vector<std::string>{
+                  R"({"x": [1, 2]})", "3.5", R"("]")", "[]", "null"}));
+
+    EXPECT_TRUE(split("[]", json::SplitMode::ArrayElements).empty());
+    EXPECT_THROW(split("{}", json::SplitMode::ArrayElements),
+                 std::runtime_error);
+}
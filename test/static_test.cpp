@@ -0,0 +1,78 @@
+#include "fast-json/static.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr auto flags = json::static_json<R"({
+    "beta": true,
+    "limits": {"requests": 100, "ratio": 0.25, "name": "default"},
+    "regions": ["eu", "us", "asia"],
+    "missing": null,
+    "empty": {}
+})">();
+
+// Everything is checked at compile time
+static_assert(flags.size() == flags.capacity());
+static_assert(flags["beta"].boolean());
+static_assert(flags["limits"]["requests"].number<int>() == 100);
+static_assert(flags["limits"]["ratio"].number<double>() == 0.25);
+static_assert(flags["limits"]["name"].str() == "default");
+static_assert(flags["regions"].size() == 3);
+static_assert(flags["regions"][2].str() == "asia");
+static_assert(flags["missing"].is_null());
+static_assert(flags["empty"].empty());
+static_assert(!(*flags).contains("gamma"));
+static_assert(json::json_internal::count_static_nodes("[1, [2, {\"a\": 3}]]") ==
+              7);
+
+constexpr int sum_regions_size() {
+    int sum = 0;
+    for (auto region : flags["regions"]) {
+        sum += static_cast<int>(region.str().size());
+    }
+    return sum;
+}
+static_assert(sum_regions_size() == 8);
+
+constexpr auto numbers = json::StaticDocument<8>{"[-12, 3e2, 1.5E-1, 0]"};
+static_assert(numbers[0].number<int>() == -12);
+static_assert(numbers[1].number<double>() == 300);
+static_assert(numbers[3].number<unsigned>() == 0);
+
+} // namespace
+
+TEST(StaticDocument, RuntimeLookups) {
+    auto key = std::string{"limits"};
+    EXPECT_EQ(flags[key]["requests"].number<int>(), 100);
+    EXPECT_EQ(numbers[2].number<double>(), 0.15);
+    EXPECT_THROW(flags["nothing"], std::out_of_range);
+    EXPECT_THROW(flags["regions"][3], std::out_of_range);
+    EXPECT_THROW(flags["beta"].number<int>(), std::invalid_argument);
+
+    auto keys = std::vector<std::string_view>{};
+    for (auto child : *flags) {
+        keys.push_back(child.raw());
+    }
+    EXPECT_EQ(keys,
+              (std::vector<std::string_view>{
+                  "beta", "limits", "regions", "missing", "empty"}));
+}
+
+TEST(StaticDocument, RuntimeParsing) {
+    auto document = json::StaticDocument<5>{R"({"a": [1, 2]})"};
+    EXPECT_EQ(document["a"][1].number<int>(), 2);
+
+    EXPECT_THROW(json::StaticDocument<4>{"[1, 2,]"}, json::ParseError);
+    EXPECT_THROW(json::StaticDocument<4>{"{\"a\" 1}"}, json::ParseError);
+    EXPECT_THROW(json::StaticDocument<4>{"[1"}, json::ParseError);
+    EXPECT_THROW(json::StaticDocument<2>{"[1, 2]"}, std::length_error);
+    EXPECT_THROW(json::StaticDocument<4>{R"(["a\q"])"}, json::ParseError);
+}
+
+TEST(StaticDocument, EscapedStrings) {
+    constexpr auto document = json::static_json<R"(["a\"b"])">();
+    EXPECT_EQ(document[0].raw(), "a\\\"b");
+    EXPECT_THROW(document[0].str(), std::invalid_argument);
+}
@@ -0,0 +1,75 @@
+#include "fast-json/json.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+auto strict = json::ParseOptions{.strict = true};
+
+} // namespace
+
+TEST(Strict, ValidDocuments) {
+    for (auto str : {
+             R"({"a": [1, -2.5, 3e10, 0.5E-3, true, false, null], "b": {}})",
+             R"([])",
+             R"("just a string \" \\ \/ \b \f \n \r \t å")",
+             R"( 10 )",
+             R"([[], [{}], {"x": []}])",
+         }) {
+        EXPECT_TRUE(json::is_valid_json(str)) << str;
+        EXPECT_NO_THROW(json::parse_json(str, strict)) << str;
+    }
+}
+
+TEST(Strict, InvalidDocuments) {
+    for (auto str : {
+             R"([1, 2,])",
+             R"({"a": 1,})",
+             R"([1 2])",
+             R"({"a" 1})",
+             R"({"a": 1 "b": 2})",
+             R"([1.2.3])",
+             R"([+1])",
+             R"([01])",
+             R"([1.])",
+             R"([1e])",
+             R"([1})",
+             R"({"a": 1])",
+             R"({"a": 1} x)",
+             R"({"a": 1} {})",
+             R"({1: 2})",
+             R"([,1])",
+             R"(["\x"])",
+             R"(["\u12"])",
+             "[\"a\tb\"]",
+             R"([)",
+             R"()",
+         }) {
+        EXPECT_FALSE(json::is_valid_json(str)) << str;
+        EXPECT_THROW(json::parse_json(str, strict), std::runtime_error)
+            << str;
+    }
+}
+
+TEST(Strict, LenientModeIsDefault) {
+    auto root = json::parse_json(R"({"a": [1, 2,], "b": 1e3})");
+    EXPECT_EQ(root["b"].number<double>(), 1000.0);
+}
+
+TEST(Strict, ParserWithOptions) {
+    auto parser = json::Parser{strict};
+    EXPECT_EQ(parser.parse(R"({"a": 10})")["a"].number(), 10);
+    EXPECT_THROW(parser.parse(R"({"a": 10,})"), std::runtime_error);
+}
+
+TEST(Strict, UnterminatedEscape) {
+    for (auto str : {"\"abc\\", "[\"abc\\", "{\"a\": \"abc\\"}) {
+        // Not null terminated, so reading past the end is noticed
+        auto input = std::vector<char>(str, str + std::strlen(str));
+        auto view = std::string_view{input.data(), input.size()};
+        EXPECT_THROW(json::parse_json(view), json::ParseError) << str;
+        EXPECT_THROW(json::parse_json(view, strict), json::ParseError) << str;
+    }
+}
@@ -0,0 +1,119 @@
+#include "fast-json/transform.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+TEST(Transform, KeepsUnchangedText) {
+    auto input = std::string{"{ \"a\" : [1,  2.50],\n\"b\": {\"c\": null} }"};
+    EXPECT_EQ(json::JsonTransform{}.apply(input), input);
+    EXPECT_EQ(json::JsonTransform{}.drop("/x").apply(input), input);
+}
+
+TEST(Transform, Drop) {
+    auto input = std::string{R"({"a": 1, "b": {"c": [2]}, "d": 3})"};
+    EXPECT_EQ(json::JsonTransform{}.drop("/a").apply(input),
+              R"({"b": {"c": [2]}, "d": 3})");
+    EXPECT_EQ(json::JsonTransform{}.drop("/b").apply(input),
+              R"({"a": 1, "d": 3})");
+    EXPECT_EQ(json::JsonTransform{}.drop("/d").apply(input),
+              R"({"a": 1, "b": {"c": [2]}})");
+    EXPECT_EQ(json::JsonTransform{}.drop("/a").drop("/b").apply(input),
+              R"({"d": 3})");
+    EXPECT_EQ(
+        json::JsonTransform{}.drop("/a").drop("/b").drop("/d").apply(input),
+        "{}");
+    EXPECT_EQ(json::JsonTransform{}.drop("/b/c").apply(input),
+              R"({"a": 1, "b": {}, "d": 3})");
+
+    // Pretty printed text stays pretty printed
+    auto pretty = std::string{"{\n  \"a\": 1,\n  \"b\": 2,\n  \"c\": 3\n}"};
+    EXPECT_EQ(json::JsonTransform{}.drop("/a").apply(pretty),
+              "{\n  \"b\": 2,\n  \"c\": 3\n}");
+    EXPECT_EQ(json::JsonTransform{}.drop("/c").apply(pretty),
+              "{\n  \"a\": 1,\n  \"b\": 2\n}");
+}
+
+TEST(Transform, DropAndReplace) {
+    auto input = std::string{R"({"a": 1, "b": 2, "c": 3})"};
+    EXPECT_EQ(json::JsonTransform{}.replace("/a", "0").drop("/b").apply(input),
+              R"({"a": 0, "c": 3})");
+    EXPECT_EQ(json::JsonTransform{}.drop("/a").replace("/b", "0").apply(input),
+              R"({"b": 0, "c": 3})");
+    EXPECT_EQ(json::JsonTransform{}.replace("/b", "0").drop("/c").apply(input),
+              R"({"a": 1, "b": 0})");
+    EXPECT_EQ(json::JsonTransform{}
+                  .replace("/a", "0")
+                  .drop("/b")
+                  .drop("/c")
+                  .apply(input),
+              R"({"a": 0})");
+    EXPECT_EQ(json::JsonTransform{}
+                  .drop("/a")
+                  .replace("/b", "0")
+                  .drop("/c")
+                  .apply(input),
+              R"({"b": 0})");
+}
+
+TEST(Transform, ArrayElements) {
+    auto input = std::string{
+        R"({"items": [{"sku": "a", "price": 1}, {"price": 2, "sku": "b"}]})"};
+    EXPECT_EQ(json::JsonTransform{}.drop("/items/*/price").apply(input),
+              R"({"items": [{"sku": "a"}, {"sku": "b"}]})");
+}
+
+TEST(Transform, RenameAndReplace) {
+    auto input = std::string{R"({"user": {"name": "Ann", "pw": "secret"}})"};
+    auto transform = json::JsonTransform{};
+    transform.rename("/user/name", "full \"name\"")
+        .replace("/user/pw", R"("***")")
+        .rename("/user/pw", "password");
+    EXPECT_EQ(transform.apply(input),
+              R"({"user": {"full \"name\"": "Ann", "password": "***"}})");
+
+    // The callback gets the source text of the value
+    auto nulled = json::JsonTransform{}.replace("/user", [](auto value) {
+        EXPECT_EQ(value, R"({"name": "Ann", "pw": "secret"})");
+        return std::string{"null"};
+    });
+    EXPECT_EQ(nulled.apply(input), R"({"user": null})");
+}
+
+TEST(Transform, OnMember) {
+    auto input = std::string{
+        R"({"password": "a", "list": [{"password": "b", "x": 1}]})"};
+    auto transform = json::JsonTransform{};
+    transform.on_member(
+        [](std::string_view path) -> std::optional<json::MemberRule> {
+            if (path.ends_with("/password")) {
+                auto rule = json::MemberRule{};
+                rule.drop = true;
+                return rule;
+            }
+            return std::nullopt;
+        });
+    EXPECT_EQ(transform.apply(input), R"({"list": [{"x": 1}]})");
+
+    // Rules by path are used first
+    transform.rename("/password", "pw");
+    EXPECT_EQ(transform.apply(input), R"({"pw": "a", "list": [{"x": 1}]})");
+}
+
+TEST(Transform, EscapedKeys) {
+    auto input = std::string{R"({"a\/b": 1, "c": 2})"};
+    EXPECT_EQ(json::JsonTransform{}.drop("/a~1b").apply(input),
+              R"({"c": 2})");
+}
+
+TEST(Transform, Stream) {
+    auto os = std::ostringstream{};
+    json::JsonTransform{}.drop("/*/a").apply(R"([{"a": 1}, "a", 2])", os);
+    EXPECT_EQ(os.str(), R"([{}, "a", 2])");
+}
+
+TEST(Transform, InvalidInput) {
+    auto transform = json::JsonTransform{}.drop("/a");
+    EXPECT_THROW(transform.apply(R"({"a": 1, "b": })"), json::ParseError);
+    EXPECT_THROW(transform.apply(R"({"a": [1})"), json::ParseError);
+    EXPECT_THROW(transform.apply(R"({"b": 1)"), json::ParseError);
+}
@@ -0,0 +1,77 @@
+#include "fast-json/json.h"
+#include "fast-json/utf8.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+namespace {
+
+bool is_valid_scalar(std::string_view str) {
+    auto p = reinterpret_cast<const unsigned char *>(str.data());
+    return json::json_internal::find_invalid_utf8_scalar(p, p + str.size()) ==
+           p + str.size();
+}
+
+} // namespace
+
+TEST(Utf8, ValidAndInvalidSequences) {
+    for (auto str : {"", "ascii", "å ä ö", "€", "𝄞 music", "\x7f"}) {
+        EXPECT_TRUE(json::is_valid_utf8(str)) << str;
+    }
+
+    for (auto str : {
+             "\x80",             // Lone continuation
+             "\xc3",             // Truncated
+             "\xc3\x28",         // Invalid continuation
+             "\xc0\xaf",         // Overlong
+             "\xe0\x80\xaf",     // Overlong
+             "\xed\xa0\x80",     // Surrogate
+             "\xf4\x90\x80\x80", // Above U+10FFFF
+             "\xf8\x88\x80\x80\x80",
+             "\xff",
+         }) {
+        EXPECT_FALSE(json::is_valid_utf8(str));
+        // Also test in the middle and at the end of longer strings
+        auto padded = std::string(20, 'a') + str + std::string(20, 'b');
+        EXPECT_FALSE(json::is_valid_utf8(padded));
+        EXPECT_FALSE(json::is_valid_utf8(std::string(31, 'a') + str));
+    }
+}
+
+TEST(Utf8, RandomizedAgainstScalar) {
+    auto gen = std::mt19937{1};
+    auto characters = std::vector<std::string>{"a", "å", "€", "𝄞", " "};
+    for (int i = 0; i < 2000; ++i) {
+        auto str = std::string{};
+        auto length = gen() % 80;
+        for (size_t j = 0; j < length; ++j) {
+            str += characters.at(gen() % characters.size());
+        }
+        if (!str.empty() && gen() % 2) {
+            // Corrupt a random byte
+            str.at(gen() % str.size()) = static_cast<char>(gen());
+        }
+        EXPECT_EQ(json::is_valid_utf8(str), is_valid_scalar(str)) << str;
+    }
+}
+
+TEST(Utf8, ParseOption) {
+    auto options = json::ParseOptions{.validate_utf8 = true};
+    EXPECT_NO_THROW(json::parse_json(R"({"name": "Åsa"})", options));
+    EXPECT_THROW(json::parse_json("{\"name\": \"\xc3\x28\"}", options),
+                 std::runtime_error);
+    EXPECT_FALSE(json::is_valid_json("[\"\xff\"]"));
+
+    // The default is to not check
+    EXPECT_NO_THROW(json::parse_json("{\"name\": \"\xc3\x28\"}"));
+}
+
+TEST(Utf8, UnicodeEscapes) {
+    auto root = json::parse_json(
+        R"(["Aå€", "𝄞", "\udd1e", "\ud834x"])");
+    auto it = root->begin();
+    EXPECT_EQ((it++)->str(), "Aå€");
+    EXPECT_EQ((it++)->str(), "𝄞");
+    EXPECT_THROW((it++)->str(), std::runtime_error);
+    EXPECT_THROW((it++)->str(), std::runtime_error);
+}
@@ -0,0 +1,50 @@
+#include "fast-json/writer.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace {
+
+const auto example = std::string_view{R"({
+    "name": "John",
+    "contact": { "email": "john@example.com",  "phone": [1, 2] },
+    "courses": [ "math" , "history" ]
+})"};
+
+} // namespace
+
+TEST(Writer, UntouchedDocumentIsCopied) {
+    auto root = json::parse_json(example);
+
+    auto out = std::string{};
+    json::write_json(*root, out);
+    EXPECT_EQ(out, example);
+
+    auto ss = std::ostringstream{};
+    json::write_json(root["contact"], ss);
+    EXPECT_EQ(ss.str(),
+              R"({ "email": "john@example.com",  "phone": [1, 2] })");
+}
+
+TEST(Writer, OnlyModifiedPartsAreFormatted) {
+    auto doc = json::MutableDocument{example};
+    doc.replace("/name", R"("Jane")");
+    doc.add("/courses/-", R"( { "x" :  1 } )");
+
+    EXPECT_EQ(json::to_json_string(doc),
+              R"({"name":"Jane",)"
+              R"("contact":{ "email": "john@example.com",  "phone": [1, 2] },)"
+              R"("courses":["math","history",{ "x" :  1 }]})");
+}
+
+TEST(Writer, CopiedValues) {
+    auto doc = json::MutableDocument{example};
+    doc.copy("/contact", "/other");
+    doc.rename("/courses", "subjects");
+
+    auto result = json::to_json_string(doc);
+    auto root = json::parse_json(result);
+
+    EXPECT_EQ(root["other"]["phone"].as<std::vector<int>>(),
+              (std::vector<int>{1, 2}));
+    EXPECT_EQ(root["subjects"].source(), R"([ "math" , "history" ])");
+}